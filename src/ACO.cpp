@@ -1,37 +1,182 @@
 #include "ACO.h"
+#include "Kernels.h"
 
-namespace constants{
-  float alpha = 1.0f;
-  float beta = 5.0f;
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+/* 
+ * Builds everything the constructor needs, timing each phase for getStartupTimings()
+ */
+void ACO::initializeInstance(int candidateListSize) {
+    using clock_type = chrono::steady_clock;
+    auto seconds = [](clock_type::time_point from, clock_type::time_point to) {
+        return chrono::duration<double>(to - from).count();
+    };
+
+    auto t0 = clock_type::now();
+    initializeParameters();
+    auto t1 = clock_type::now();
+    computeHeuristicInformation();
+    auto t2 = clock_type::now();
+    initializeCandidateLists(candidateListSize);
+    auto t3 = clock_type::now();
+    initializePheromoneTrails();
+    auto t4 = clock_type::now();
+    computeChoiceInformation();
+    auto t5 = clock_type::now();
+
+    startupTimings.distances = seconds(t0, t1);
+    startupTimings.heuristics = seconds(t1, t2);
+    startupTimings.candidateLists = seconds(t2, t3);
+    startupTimings.pheromones = seconds(t3, t4);
+    startupTimings.choiceInfo = seconds(t4, t5);
+    startupTimings.total = seconds(t0, t5);
 }
 
 /* 
  * Initializes parameters for the ACO algorithm:
  * - Sets up the proximity matrix using Euclidean distances
+ * - Coordinates are copied into contiguous x/y arrays once, so the distance kernel streams
+ *   through them instead of chasing a pointer per city
+ * - The matrix is symmetric: it is cut into tileSize x tileSize tiles and only tiles on or
+ *   above the diagonal are computed, each off-diagonal one also written to its mirror tile
+ * - Tiles are handed to the execution backend one by one (the rows above the diagonal get shorter)
  */
 void ACO::initializeParameters() {
-    size_t num = citys.size();
+    const size_t num = citys.size();
+    constexpr size_t tileSize = 64;
 
-    // Set proximity matrix based on Euclidean distance
-    proximitys.resize(num, vector<float>(num, 0.0f));
+    // Allocate and zero in parallel (also places the pages, see firstTouch)
+    firstTouch(proximitys, num, num, 0.0f);
 
     // Initialize probability matrix (used by GUI for visualization)
-    probablitys.resize(num, vector<float>(num, 0.0f));
+    firstTouch(probablitys, num, num, 0.0f);
 
+    vector<float> xs(num), ys(num);
     for (size_t i = 0; i < num; ++i) {
-        for (size_t j = 0; j < num; ++j) {
-            float dx = citys[i]->position.x - citys[j]->position.x;
-            float dy = citys[i]->position.y - citys[j]->position.y;
-            proximitys[i][j] = std::sqrt(dx * dx + dy * dy); // Euclidean distance
+        xs[i] = citys[i]->position.x;
+        ys[i] = citys[i]->position.y;
+    }
+
+    const size_t tiles = (num + tileSize - 1) / tileSize;
+    const int64_t tilePairs = static_cast<int64_t>(tiles * (tiles + 1) / 2);
+    const kernels::KernelTable& simd = kernels::active();
+
+    backend->forEach(static_cast<int>(tilePairs), [&](int pair) {
+        // Unrank pair -> (ti, tj) with ti <= tj, row by row of the upper triangle
+        size_t ti = 0;
+        int64_t rest = pair;
+        while (rest >= static_cast<int64_t>(tiles - ti)) {
+            rest -= static_cast<int64_t>(tiles - ti);
+            ++ti;
+        }
+        const size_t tj = ti + static_cast<size_t>(rest);
+
+        const size_t rowBegin = ti * tileSize;
+        const size_t rowCount = std::min(num, rowBegin + tileSize) - rowBegin;
+        const size_t colBegin = tj * tileSize;
+        const size_t colCount = std::min(num, colBegin + tileSize) - colBegin;
+
+        // Tile computed into a local buffer, then stored row by row to both the tile and
+        // its mirror, so every matrix row is written as one contiguous run per tile
+        alignas(AlignedMatrix::alignment) float tile[tileSize * tileSize];
+        for (size_t r = 0; r < rowCount; ++r) {
+            const size_t i = rowBegin + r;
+            simd.distanceRow(xs[i], ys[i], xs.data() + colBegin, ys.data() + colBegin, tile + r * tileSize, colCount);
+        }
+        if (ti == tj) {
+            // Vector lanes and the scalar tail may round differently; keep the tile exactly symmetric
+            for (size_t r = 1; r < rowCount; ++r) {
+                for (size_t c = 0; c < r; ++c) {
+                    tile[r * tileSize + c] = tile[c * tileSize + r];
+                }
+            }
         }
+        for (size_t r = 0; r < rowCount; ++r) {
+            std::copy(tile + r * tileSize, tile + r * tileSize + colCount, proximitys.row(rowBegin + r) + colBegin);
+        }
+        if (ti != tj) {
+            for (size_t c = 0; c < colCount; ++c) {
+                float* mirror = proximitys.row(colBegin + c) + rowBegin;
+                for (size_t r = 0; r < rowCount; ++r) {
+                    mirror[r] = tile[r * tileSize + c];
+                }
+            }
+        }
+    });
+}
+
+/* 
+ * Fills heuristics[i][j] = (1 / distance)^beta
+ * - The diagonal is left at zero since a city is never chosen from itself
+ */
+void ACO::computeHeuristicInformation() {
+    const size_t num = citys.size();
+    if (heuristics.rows() != num) {
+        firstTouch(heuristics, num, num, 0.0f);
     }
+
+    backend->forEach(static_cast<int>(num), [&](int i) {
+        weightKernel->heuristicRow(proximitys.row(i), heuristics.row(i), num, beta);
+        heuristics.row(i)[i] = 0.0f;
+    });
+}
+
+/* 
+ * Refreshes choiceInfo[i][j] = tau^alpha * eta^beta in a single pass
+ * - Called once per iteration so tour construction only does lookups
+ * - Uses the alpha-specialized kernel picked in setAlpha/setBeta
+ */
+void ACO::computeChoiceInformation() {
+    const size_t num = citys.size();
+    if (choiceInfo.rows() != num) {
+        firstTouch(choiceInfo, num, num, 0.0f);
+    }
+
+    backend->forEach(static_cast<int>(num), [&](int i) {
+        weightKernel->choiceRow(pheromones.row(i), heuristics.row(i), choiceInfo.row(i), num, alpha);
+    });
 }
+/* 
+ * Builds the candidate list of every city
+ * - Each list holds the listSize nearest other cities, nearest first
+ * - Tour construction samples only from these, so a step costs O(listSize) instead of O(n)
+ */
+void ACO::initializeCandidateLists(int listSize) {
+    const int num = static_cast<int>(citys.size());
+    if (listSize <= 0 || listSize > num - 1) {
+        listSize = std::max(num - 1, 0);
+    }
+    nnListSize = listSize;
+    nearestNeighbors.assign(static_cast<size_t>(num) * nnListSize, 0);
+    if (nnListSize == 0) {
+        return;
+    }
+
+    backend->forEach(num, [&](int i) {
+        const float* dist = proximitys.row(i);
+        vector<int> order(num);
+        iota(order.begin(), order.end(), 0);
+        swap(order[i], order[num - 1]); // keep the city itself out of its own list
+
+        partial_sort(order.begin(), order.begin() + nnListSize, order.end() - 1,
+            [dist](int a, int b) { return dist[a] < dist[b]; });
+
+        copy(order.begin(), order.begin() + nnListSize,
+            nearestNeighbors.begin() + static_cast<size_t>(i) * nnListSize);
+    });
+}
+
 /* 
  * Initializes pheromone trails to a starting value
  */
 void ACO::initializePheromoneTrails(){
-    for (auto& row : pheromones) {
-        fill(row.begin(), row.end(), 1.0f);
+    if (pheromones.rows() != citys.size()) {
+        firstTouch(pheromones, citys.size(), citys.size(), 1.0f);
+    }
+    else {
+        pheromones.fill(1.0f);
     }
 }
 
@@ -45,197 +190,1419 @@ bool ACO::terminationCondition(int iteration){
 
 /* 
  * Updates the probability of an ant moving to all feasible cities
+ * - weights[k] is the selection weight of candidate k (zero once visited)
+ * - Only used for the GUI, tour construction never normalizes
  */
-void ACO::updateProbablity(shared_ptr<Ant> ant,
-    const vector<int>& feasibleCityIndexes,
-    vector<float>* localProbRow) {
-    int i = ant->currCity->id;
-    float bottom = 0.0f;
+void ACO::updateProbablity(const Ant& ant, const float* weights, float total) {
+    int i = ant.currCity;
+    const int* candidates = nearestNeighbors.data() + static_cast<size_t>(i) * nnListSize;
 
-    // Calculate the denominator of the probability equation
-    for (int j : feasibleCityIndexes) {
-        float heuristic = 1.0f / std::max(proximitys[i][j], 1e-6f);
-        float sum = std::pow(pheromones[i][j], constants::alpha) *
-            std::pow(heuristic, constants::beta);
-        bottom += sum;
+    int feasible = 0;
+    for (int k = 0; k < nnListSize; ++k) {
+        feasible += !ant.hasVisited(candidates[k]);
     }
 
-    if (bottom <= 0.0f) {
+    for (int k = 0; k < nnListSize; ++k) {
+        int j = candidates[k];
+        if (ant.hasVisited(j)) {
+            continue;
+        }
+
         // Degenerate case: fall back to uniform probabilities.
-        float uniform = 1.0f / static_cast<float>(feasibleCityIndexes.size());
-        if (localProbRow) {
-            if (localProbRow->size() < citys.size()) {
-                localProbRow->assign(citys.size(), 0.0f);
+        float p = (total > 0.0f) ? weights[k] / total : 1.0f / static_cast<float>(feasible);
+        probablitys[i][j] = p;
+        probablitys[j][i] = p;
+    }
+}
+
+/* 
+ * Updates pheromones based on the ant's path
+ * - Deposits are gathered first, then one cache-blocked sweep over the matrix
+ *   evaporates, applies them, clamps and refreshes the choice information
+ */
+void ACO::updatePheromones() {
+    if (backend->kind() != BackendKind::OpenMP) {
+        updatePheromonesOnBackend(*backend);
+        return;
+    }
+#pragma omp parallel num_threads(teamSize())
+    updatePheromonesInTeam();
+}
+
+/* 
+ * Team-wide body of updatePheromones
+ * - Uses orphaned worksharing, so it binds to whatever team calls it: a fresh
+ *   one from updatePheromones or the persistent pool of run()
+ */
+void ACO::updatePheromonesInTeam() {
+    const float keep = 1.0f - evaporationRate;
+
+    // Deposit pheromones based on each ant's route
+    bool pendingDeltas = depositPheromones(keep);
+
+    // Evaporate, finish the deposit and refresh the cached selection weights
+    evaporateAndRefresh(keep, pendingDeltas);
+}
+
+/*
+ * Resolves the deposit strategy of an update
+ * - Auto is sort-reduce for every team, one thread included: it alone sums each edge's deposits
+ *   in ant order and adds the sum once onto the evaporated value, so run() is bit-identical
+ *   across thread counts by default
+ * - Sequential (pre-scaled by 1 / keep) and Atomic (arrival order) are explicit opt-ins that
+ *   trade that for less overhead
+ */
+DepositStrategy ACO::chooseDepositStrategy() const {
+    if (deterministic || depositStrategy == DepositStrategy::Auto) {
+        return DepositStrategy::SortReduce;
+    }
+    return depositStrategy;
+}
+
+/*
+ * Fixes the strategy of this update and readies the sort-reduce buckets
+ * - Called by one thread, before any deposit of the update
+ * - concurrent: deposits will come from several threads at once (the task graph of run()),
+ *   so Sequential is only kept for a team of one and otherwise becomes SortReduce; only an
+ *   explicit Atomic gives up the fixed summation order
+ */
+void ACO::prepareDeposit(int team, float keep, bool concurrent) {
+    activeDepositStrategy = chooseDepositStrategy();
+    if (concurrent && team > 1 && activeDepositStrategy == DepositStrategy::Sequential) {
+        activeDepositStrategy = DepositStrategy::SortReduce;
+    }
+
+    // Pre-scaling needs keep > 0; full evaporation has to take the delta path
+    if (keep <= 0.0f) {
+        activeDepositStrategy = DepositStrategy::SortReduce;
+    }
+
+    if (activeDepositStrategy == DepositStrategy::SortReduce) {
+        depositBuckets.resize(static_cast<size_t>(team) * team);
+        for (auto& bucket : depositBuckets) {
+            bucket.clear();
+        }
+        depositRows.assign(citys.size(), { 0, 0 });
+        depositTeam = team;
+    }
+}
+
+/*
+ * Deposits one ant's tour with the active strategy
+ * - Sequential and Atomic add Q / (keep * routeLength) in place, so the
+ *   evaporation sweep that follows scales them to exactly Q / routeLength
+ * - SortReduce files Q / routeLength into producer's bucket of each row owner,
+ *   where owner t holds the rows [t * n / team, (t + 1) * n / team)
+ *   Both directions are filed so every row's deltas end up with that row's owner
+ */
+void ACO::depositAnt(const Ant& ant, int antIndex, int producer, float keep) {
+    if (ant.route.size() < 2 || ant.routeLength <= 0.0f) {
+        return;
+    }
+
+    if (activeDepositStrategy == DepositStrategy::Sequential) {
+        float concentration = Q / (keep * ant.routeLength);
+
+        for (std::size_t i = 0; i + 1 < ant.route.size(); ++i) {
+            int a = ant.route[i];
+            int b = ant.route[i + 1];
+
+            pheromones[a][b] += concentration;
+            pheromones[b][a] += concentration;
+        }
+        return;
+    }
+
+    if (activeDepositStrategy == DepositStrategy::Atomic) {
+        float concentration = Q / (keep * ant.routeLength);
+
+        for (std::size_t i = 0; i + 1 < ant.route.size(); ++i) {
+            int a = ant.route[i];
+            int b = ant.route[i + 1];
+
+            // atomic_ref rather than omp atomic: Atomic deposits also come from non-OpenMP backends
+            atomic_ref<float>(pheromones.row(a)[b]).fetch_add(concentration, memory_order_relaxed);
+            atomic_ref<float>(pheromones.row(b)[a]).fetch_add(concentration, memory_order_relaxed);
+        }
+        return;
+    }
+
+    const uint64_t team = static_cast<uint64_t>(depositTeam);
+    const uint64_t n = citys.size();
+    vector<EdgeDelta>* produced = &depositBuckets[static_cast<size_t>(producer) * team];
+    float concentration = Q / ant.routeLength;
+
+    for (std::size_t i = 0; i + 1 < ant.route.size(); ++i) {
+        uint64_t a = ant.route[i];
+        uint64_t b = ant.route[i + 1];
+        produced[a * team / n].push_back({ a * n + b, concentration, static_cast<uint32_t>(antIndex) });
+        produced[b * team / n].push_back({ b * n + a, concentration, static_cast<uint32_t>(antIndex) });
+    }
+}
+
+/*
+ * Sort-reduce owner pass for one owner's rows
+ * - Merges the buckets addressed to owner, sorts by edge, reduces duplicates and
+ *   records where each row's deltas start and end
+ * - Needs every deposit of the update to be filed; owners are independent of each other
+ */
+void ACO::reduceDeposits(int owner) {
+    const size_t team = static_cast<size_t>(depositTeam);
+    const uint64_t n = citys.size();
+
+    vector<EdgeDelta> owned;
+    for (size_t t = 0; t < team; ++t) {
+        const vector<EdgeDelta>& bucket = depositBuckets[t * team + owner];
+        owned.insert(owned.end(), bucket.begin(), bucket.end());
+    }
+    // Ties broken by ant, so every edge sums its deposits in ant order whatever the team size
+    std::sort(owned.begin(), owned.end(),
+        [](const EdgeDelta& x, const EdgeDelta& y) { return x.edge < y.edge || (x.edge == y.edge && x.ant < y.ant); });
+
+    size_t reduced = 0;
+    for (size_t k = 0; k < owned.size(); ++reduced) {
+        EdgeDelta sum = owned[k++];
+        for (; k < owned.size() && owned[k].edge == sum.edge; ++k) {
+            sum.amount += owned[k].amount;
+        }
+        owned[reduced] = sum;
+
+        pair<size_t, size_t>& rowRange = depositRows[sum.edge / n];
+        if (rowRange.second == 0) {
+            rowRange.first = reduced;
+        }
+        rowRange.second = reduced + 1;
+    }
+    owned.resize(reduced);
+
+    // Only this owner's sweep reads its diagonal bucket, so it can hold the reduced list
+    depositBuckets[static_cast<size_t>(owner) * team + owner].swap(owned);
+}
+
+/*
+ * Deposits pheromones along each ant's route, ahead of evaporation
+ * - Sequential runs on one thread; Atomic and SortReduce spread the ants over the team
+ * - SortReduce leaves sorted per-row deltas in depositBuckets for the sweep to apply
+ * - Called by every thread of the team; returns true when deltas are pending
+ */
+bool ACO::depositPheromones(float keep) {
+    const int team = omp_get_num_threads();
+    const int self = omp_get_thread_num();
+    const int numAnts = static_cast<int>(ants.size());
+
+#pragma omp single
+    prepareDeposit(team, keep, false);
+    // implicit barrier: the whole team sees the same strategy
+
+    if (activeDepositStrategy == DepositStrategy::Sequential) {
+#pragma omp single
+        for (int k = 0; k < numAnts; ++k) {
+            depositAnt(*ants[k], k, self, keep);
+        }
+        return false;
+    }
+
+    if (activeDepositStrategy == DepositStrategy::Atomic) {
+#pragma omp for schedule(dynamic, 1)
+        for (int k = 0; k < numAnts; ++k) {
+            depositAnt(*ants[k], k, self, keep);
+        }
+        return false;
+    }
+
+#pragma omp for schedule(static)
+    for (int k = 0; k < numAnts; ++k) {
+        depositAnt(*ants[k], k, self, keep);
+    }
+    // implicit barrier: every bucket is complete
+
+    reduceDeposits(self);
+
+#pragma omp barrier
+    return true;
+}
+
+/*
+ * One cache-blocked sweep over the matrices, tile by tile along each row:
+ * evaporate, apply the pending deltas that fall in the tile, clamp to
+ * [minPheromone, maxPheromone] and write the refreshed choice information
+ * - Matrices larger than the last-level cache get the choice tile written
+ *   with streaming stores, since it is not read again until the next iteration
+ * - Called by every thread of the team
+ */
+void ACO::evaporateAndRefresh(float keep, bool pendingDeltas) {
+    const bool streaming = choiceInfo.paddedSize() * sizeof(float) > streamingStoreThreshold;
+
+#pragma omp for schedule(static)
+    for (int i = 0; i < static_cast<int>(citys.size()); ++i) {
+        refreshRows(i, i + 1, keep, pendingDeltas);
+    }
+
+    if (streaming) {
+        kernels::streamFence();
+    }
+#pragma omp barrier
+}
+
+/*
+ * Body of the fused sweep for rows [begin, end)
+ * - With pending deltas, every row's owner must have run reduceDeposits first
+ * - Streaming stores are not fenced here; the caller fences before anyone reads choiceInfo
+ */
+void ACO::refreshRows(int begin, int end, float keep, bool pendingDeltas) {
+    const size_t n = citys.size();
+    const size_t stride = pheromones.stride();
+    const kernels::KernelTable& simd = kernels::active();
+    const bool streaming = choiceInfo.paddedSize() * sizeof(float) > streamingStoreThreshold;
+    const uint64_t team = static_cast<uint64_t>(depositTeam);
+
+    alignas(AlignedMatrix::alignment) float tile[fusedTileWidth];
+
+    for (int i = begin; i < end; ++i) {
+        float* tau = pheromones.row(i);
+        const float* eta = heuristics.row(i);
+        float* choice = choiceInfo.row(i);
+
+        // This row's deltas, sorted by column
+        const EdgeDelta* delta = nullptr;
+        const EdgeDelta* deltaEnd = nullptr;
+        if (pendingDeltas) {
+            uint64_t owner = static_cast<uint64_t>(i) * team / n;
+            const vector<EdgeDelta>& owned = depositBuckets[owner * team + owner];
+            delta = owned.data() + depositRows[i].first;
+            deltaEnd = owned.data() + depositRows[i].second;
+        }
+
+        for (size_t c0 = 0; c0 < n; c0 += fusedTileWidth) {
+            const size_t width = std::min(fusedTileWidth, n - c0);
+            const size_t paddedWidth = std::min(fusedTileWidth, stride - c0);
+
+            simd.scale(tau + c0, paddedWidth, keep);
+
+            for (; delta != deltaEnd && delta->edge % n < c0 + width; ++delta) {
+                tau[delta->edge % n] += delta->amount;
             }
-            for (int j : feasibleCityIndexes) {
-                (*localProbRow)[j] = uniform;
+
+            for (size_t j = c0; j < c0 + width; ++j) {
+                tau[j] = std::min(std::max(tau[j], minPheromone), maxPheromone);
             }
-        }
-        else {
-            for (int j : feasibleCityIndexes) {
-                probablitys[i][j] = uniform;
-                probablitys[j][i] = uniform;
+
+            if (streaming) {
+                weightKernel->choiceRow(tau + c0, eta + c0, tile, width, alpha);
+                kernels::streamCopy(choice + c0, tile, width);
+            }
+            else {
+                weightKernel->choiceRow(tau + c0, eta + c0, choice + c0, width, alpha);
             }
         }
+    }
+}
+
+/*
+ * Runs maxIterations iterations on one persistent thread team
+ * - Only for the OpenMP backend; any other backend takes runOnBackend's phased loops
+ * - Threads, their RNGs and their workspaces live for the whole run
+ * - Each iteration is one task graph on the work-stealing scheduler, per ant:
+ *   construct -> improve (with local search) -> deposit. A worker that finishes an ant
+ *   goes on with that ant's next task, so local search and deposits overlap the
+ *   construction of the other ants
+ * - A dependency counter of outstanding deposits releases the update: the last deposit
+ *   pushes one sort-reduce task per row owner (each of which pushes its owner's sweep
+ *   tasks) or, without pending deltas, the sweep tasks directly. Sweep tasks start on
+ *   their row owner's deque, so rows stay with the thread that first touched them
+ * - The only barriers left are the ones around seeding the graph
+ * - With more threads than ants on a large instance, ant-level parallelism would leave
+ *   threads idle, so thread w instead joins ant (w % ants)'s StepTeam and helps scan its
+ *   long rows every step; that path keeps the phased update
+ */
+void ACO::run() {
+    if (backend->kind() != BackendKind::OpenMP) {
+        runOnBackend(*backend);
         return;
     }
 
-    if (localProbRow && localProbRow->size() < citys.size()) {
-        localProbRow->assign(citys.size(), 0.0f);
+    const int threads = teamSize();
+    const int numAnts = static_cast<int>(ants.size());
+    const int num = static_cast<int>(citys.size());
+    const float keep = 1.0f - evaporationRate;
+    const bool streaming = choiceInfo.paddedSize() * sizeof(float) > streamingStoreThreshold;
+
+    if (!scheduler || scheduler->workerCount() != threads) {
+        scheduler = make_unique<WorkStealingScheduler>(threads);
+    }
+    const bool replicated = !choiceReplicas.empty() && static_cast<int>(pinnedCpus.size()) == threads;
+
+    const bool teamed = numAnts > 0 && threads > numAnts && num >= parallelSelectionThreshold;
+    vector<unique_ptr<StepTeam>> stepTeams;
+    if (teamed) {
+        for (int a = 0; a < numAnts; ++a) {
+            stepTeams.push_back(make_unique<StepTeam>((threads - a + numAnts - 1) / numAnts));
+        }
     }
 
-    // Calculate probabilities of paths i to j
-    for (int j : feasibleCityIndexes) {
-        float heuristic = 1.0f / std::max(proximitys[i][j], 1e-6f);
-        float top = std::pow(pheromones[i][j], constants::alpha) *
-            std::pow(heuristic, constants::beta);
-        float p = top / bottom;
+    // Iteration graph: per-ant chain, then per-owner reduce and per-row-block sweep
+    enum IterationTask { ConstructTour = 0, ImproveTour, DepositTour, ReduceOwner, SweepRows };
+    atomic<int> depositsLeft{ 0 };
+    bool pendingDeltas = false;
 
-        if (localProbRow) {
-            (*localProbRow)[j] = p;
+    // Sweep tasks for owner t's rows, pushed on worker t's deque (stolen only on imbalance)
+    auto pushSweeps = [&](int owner, int team) {
+        const int end = ownerRowBegin(owner + 1, team);
+        for (int row = ownerRowBegin(owner, team); row < end; row += sweepTaskRows) {
+            scheduler->push(owner, { SweepRows, row });
         }
-        else {
-            probablitys[i][j] = p;
-            probablitys[j][i] = p;
+    };
+
+    // Released by the last deposit of the iteration
+    auto pushUpdate = [&]() {
+        for (int t = 0; t < threads; ++t) {
+            if (pendingDeltas) {
+                scheduler->push(t, { ReduceOwner, t });
+            }
+            else {
+                pushSweeps(t, threads);
+            }
+        }
+    };
+
+#pragma omp parallel num_threads(threads)
+    {
+        const int worker = omp_get_thread_num();
+        const numa::ScopedPin pin = pinWorker(worker);
+
+        // Per-thread state, created once for the whole run
+        ConstructionWorkspace workspace;
+        if (replicated) {
+            workspace.choice = &choiceReplicas[workerNode[worker]];
+            refreshReplica(worker);
+        }
+        const int teamAnt = teamed ? worker % numAnts : -1;
+        const int teamMember = teamed ? worker / numAnts : 0;
+        if (teamed) {
+            workspace.team = stepTeams[teamAnt].get();
+        }
+
+        for (int it = 0; !terminationCondition(it); ++it) {
+            const uint64_t iteration = completedIterations + static_cast<uint64_t>(it);
+
+            if (teamed) {
+                // Construction phase, one ant per team: its leader builds the tour, the rest help
+                if (teamMember == 0) {
+                    Ant& ant = *ants[teamAnt];
+                    constructTour(ant, iteration, teamAnt, workspace);
+                    finishStepTeam(workspace);
+                    if (localSearch) {
+                        improveTour(ant, workspace);
+                    }
+                    bestTours.offer(ant.routeLength, iteration * numAnts + teamAnt, ant.route);
+                }
+                else {
+                    assistStepTeam(*stepTeams[teamAnt], teamMember);
+                }
+#pragma omp barrier
+
+                // Update phase, on the same team
+                updatePheromonesInTeam();
+                if (replicated) {
+                    refreshReplica(worker);
+                }
+
+                // Reset phase; nobody offers until the next construction, so retired tours can go
+#pragma omp single nowait
+                bestTours.reclaim();
+#pragma omp for schedule(static)
+                for (int k = 0; k < numAnts; ++k) {
+                    ants[k]->reset();
+                }
+                continue;
+            }
+
+#pragma omp single
+            {
+                bestTours.reclaim(); // Every offer of the previous iteration is done
+                prepareDeposit(threads, keep, true);
+                pendingDeltas = activeDepositStrategy == DepositStrategy::SortReduce;
+                depositsLeft.store(numAnts, memory_order_relaxed);
+                if (numAnts > 0) {
+                    scheduler->seedBlocks(numAnts, ConstructTour);
+                }
+                else {
+                    pushUpdate();
+                }
+            }
+            // implicit barrier: every worker sees the seeded deques
+
+            scheduler->run(worker, [&](SchedulerTask task, int w) {
+                switch (task.kind) {
+                case ConstructTour:
+                    constructTour(*ants[task.index], iteration, task.index, workspace);
+                    scheduler->push(w, { localSearch ? ImproveTour : DepositTour, task.index });
+                    break;
+
+                case ImproveTour:
+                    improveTour(*ants[task.index], workspace);
+                    scheduler->push(w, { DepositTour, task.index });
+                    break;
+
+                case DepositTour: {
+                    Ant& ant = *ants[task.index];
+                    bestTours.offer(ant.routeLength, iteration * numAnts + task.index, ant.route);
+                    depositAnt(ant, task.index, w, keep);
+                    ant.reset();
+
+                    // acq_rel: the last one sees every other deposit before releasing the update
+                    if (depositsLeft.fetch_sub(1, memory_order_acq_rel) == 1) {
+                        pushUpdate();
+                    }
+                    break;
+                }
+
+                case ReduceOwner:
+                    reduceDeposits(task.index);
+                    pushSweeps(task.index, threads);
+                    break;
+
+                case SweepRows: {
+                    const int owner = static_cast<int>(static_cast<int64_t>(task.index) * threads / num);
+                    refreshRows(task.index, std::min(task.index + sweepTaskRows, ownerRowBegin(owner + 1, threads)),
+                                keep, pendingDeltas);
+                    break;
+                }
+                }
+            });
+            if (streaming) {
+                kernels::streamFence();
+            }
+#pragma omp barrier
+
+            if (replicated) {
+                refreshReplica(worker);
+            }
         }
     }
+    bestTours.reclaim();
+
+    completedIterations += static_cast<uint64_t>(std::max(maxIterations, 0));
 }
 
+/*
+ * 2-opt local search on a finished tour
+ * - For every tour edge (a, b) and each of a's nearest candidates c closer to a than b is,
+ *   tries replacing (a, b) and (c, d = successor of c) by (a, c) and (b, d); the candidate
+ *   list is sorted nearest first, so the scan of a stops at the first c with d(a, c) >= d(a, b)
+ * - A move reverses whichever of the two tour segments it splits off is contiguous in the array
+ * - Repeats passes until one finds no improving move (at most localSearchPasses)
+ * - The ant's route and length are rewritten; the tour may start at a different city
+ */
+void ACO::improveTour(Ant& ant, ConstructionWorkspace& workspace) {
+    const int n = static_cast<int>(citys.size());
+    if (n < 4 || static_cast<int>(ant.route.size()) != n + 1) {
+        return;
+    }
 
-/* 
- * Constructs solutions for the ant
+    vector<int>& tour = workspace.tour;
+    vector<int>& position = workspace.position;
+    tour.resize(n);
+    position.resize(n);
+    for (int k = 0; k < n; ++k) {
+        tour[k] = ant.route[k];
+        position[tour[k]] = k;
+    }
+
+    const int neighbours = std::min(nnListSize, localSearchNeighbours);
+    bool improved = true;
+    for (int pass = 0; improved && pass < localSearchPasses; ++pass) {
+        improved = false;
+
+        for (int i = 0; i < n; ++i) {
+            const int a = tour[i];
+            const int b = tour[(i + 1) % n];
+            const float* fromA = proximitys.row(a);
+            const float ab = fromA[b];
+            const int* candidates = nearestNeighbors.data() + static_cast<size_t>(a) * nnListSize;
+
+            for (int k = 0; k < neighbours; ++k) {
+                const int c = candidates[k];
+                const float ac = fromA[c];
+                if (ac >= ab) {
+                    break;
+                }
+
+                const int j = position[c];
+                const int d = tour[(j + 1) % n];
+                const float gain = ab + proximitys.row(c)[d] - ac - proximitys.row(b)[d];
+                if (gain <= 1e-4f) {
+                    continue;
+                }
+
+                // Reverse tour[i + 1 .. j], or equivalently tour[j + 1 .. i]
+                int lo = (i + 1) % n;
+                int hi = j;
+                if (lo > hi) {
+                    lo = j + 1;
+                    hi = i;
+                }
+                std::reverse(tour.begin() + lo, tour.begin() + hi + 1);
+                for (int p = lo; p <= hi; ++p) {
+                    position[tour[p]] = p;
+                }
+                improved = true;
+                break;
+            }
+        }
+    }
+
+    ant.route.clear();
+    float length = 0.0f;
+    for (int k = 0; k < n; ++k) {
+        ant.route.push_back(tour[k]);
+        length += proximitys.row(tour[k])[tour[(k + 1) % n]];
+    }
+    ant.route.push_back(tour[0]);
+    ant.routeLength = length;
+}
+
+/*
+ * Backend-driven variant of run(), one loop per phase
+ * - Construction (and local search) runs one ant per index, each with its own workspace,
+ *   since backends do not expose a thread number
+ * - The update is updatePheromonesOnBackend
+ * - Deterministic runs give the same tours and pheromones on every backend as run()
  */
-void ACO::constructAntSolutions(shared_ptr<Ant>& ant){
-    ant->visitCity();
+void ACO::runOnBackend(ExecutionBackend& backend) {
+    const int numAnts = static_cast<int>(ants.size());
+
+    vector<ConstructionWorkspace> workspaces(numAnts);
+
+    for (int it = 0; !terminationCondition(it); ++it) {
+        const uint64_t iteration = completedIterations + static_cast<uint64_t>(it);
+
+        backend.forEach(numAnts, [&](int k) {
+            constructTour(*ants[k], iteration, k, workspaces[k]);
+            if (localSearch) {
+                improveTour(*ants[k], workspaces[k]);
+            }
+        });
+        for (int k = 0; k < numAnts; ++k) {
+            bestTours.offer(ants[k]->routeLength, iteration * numAnts + k, ants[k]->route);
+        }
+        bestTours.reclaim();
+
+        updatePheromonesOnBackend(backend);
+
+        backend.forEach(numAnts, [&](int k) {
+            ants[k]->reset();
+        });
+    }
+
+    completedIterations += static_cast<uint64_t>(std::max(maxIterations, 0));
 }
 
-/* 
- * Updates pheromones based on the ant's path
+/*
+ * Deposit and sweep of one update, each phase one backend loop
+ * - Sort-reduce deposits use concurrency() fixed producer chunks of ants and as many row
+ *   owners, so the deltas are filed without knowing which thread runs a chunk
+ * - The sweep runs sweepTaskRows row blocks under forEachUnsequenced, each fencing its own
+ *   streaming stores
  */
-void ACO::updatePheromones() {
-    // Evaporate pheromones
+void ACO::updatePheromonesOnBackend(ExecutionBackend& backend) {
+    const int numAnts = static_cast<int>(ants.size());
+    const int num = static_cast<int>(citys.size());
+    const int lanes = std::max(1, std::min(backend.concurrency(), std::max(numAnts, 1)));
     const float keep = 1.0f - evaporationRate;
-    const std::size_t n = pheromones.size();
+    const bool streaming = choiceInfo.paddedSize() * sizeof(float) > streamingStoreThreshold;
+    const int blocks = (num + sweepTaskRows - 1) / sweepTaskRows;
 
-#if ENABLE_PARALLEL && PARALLEL_PHEROMONES
-    // Parallel evaporation over the full matrix
-#pragma omp parallel for collapse(2)
-    for (int i = 0; i < static_cast<int>(n); ++i) {
-        for (int j = 0; j < static_cast<int>(pheromones[i].size()); ++j) {
-            pheromones[i][j] *= keep;
+    prepareDeposit(lanes, keep, lanes > 1);
+    const bool pendingDeltas = activeDepositStrategy == DepositStrategy::SortReduce;
+    if (activeDepositStrategy == DepositStrategy::Sequential) {
+        for (int k = 0; k < numAnts; ++k) {
+            depositAnt(*ants[k], k, 0, keep);
         }
     }
-#else
-    // Sequential evaporation (no OpenMP)
-    for (auto& row : pheromones) {
-        for (auto& p : row) {
-            p *= keep;
+    else if (activeDepositStrategy == DepositStrategy::Atomic) {
+        backend.forEach(numAnts, [&](int k) {
+            depositAnt(*ants[k], k, 0, keep);
+        });
+    }
+    else {
+        backend.forEach(lanes, [&](int producer) {
+            const int end = (producer + 1) * numAnts / lanes;
+            for (int k = producer * numAnts / lanes; k < end; ++k) {
+                depositAnt(*ants[k], k, producer, keep);
+            }
+        });
+        backend.forEach(lanes, [&](int owner) {
+            reduceDeposits(owner);
+        });
+    }
+
+    backend.forEachUnsequenced(blocks, [&](int block) {
+        const int begin = block * sweepTaskRows;
+        refreshRows(begin, std::min(begin + sweepTaskRows, num), keep, pendingDeltas);
+        if (streaming) {
+            kernels::streamFence();
         }
+    });
+}
+
+/*
+ * Pipelined variant of run(): the pheromone update leaves the critical path
+ * - Iteration k's update runs on its own std::thread and OpenMP team while the construction
+ *   team already builds iteration k + 1 into the second ant set
+ * - Constructors only read pipelineChoice; the updater writes tau and choiceInfo. After each
+ *   construction phase one thread waits for the previous update (the published epoch), swaps
+ *   the two choice matrices and the two ant sets, and hands the next update over
+ * - So iteration k + 1 is built on the choice information of iteration k - 1's update,
+ *   and an update only stalls construction when it takes longer than a construction phase
+ * - NUMA replicas are not used, the snapshot is already a private copy
+ */
+void ACO::runPipelined() {
+    const int threads = teamSize();
+    const int numAnts = static_cast<int>(ants.size());
+    const int iterations = std::max(maxIterations, 0);
+    if (iterations == 0 || numAnts == 0) {
+        return;
     }
-#endif
 
-    // Deposit pheromones based on each ant's route (kept sequential for now)
-    for (auto& ant : ants) {
-        if (ant->route.size() < 2 || ant->routeLength <= 0.0f) {
-            continue;
+    const int updaters = updaterThreads > 0 ? updaterThreads : std::max(1, threads / 4);
+    const int constructors = std::max(1, threads - updaters);
+
+    if (!scheduler || scheduler->workerCount() != constructors) {
+        scheduler = make_unique<WorkStealingScheduler>(constructors);
+    }
+    if (pipelineAnts.size() != ants.size()) {
+        pipelineAnts.clear();
+        for (int k = 0; k < numAnts; ++k) {
+            pipelineAnts.push_back(make_shared<Ant>(k, citys.size()));
         }
+    }
+    pipelineChoice.copyFrom(choiceInfo);
 
-        float concentration = Q / ant->routeLength;
+    atomic<int> requested{ 0 }; // Updates handed to the updater
+    atomic<int> epoch{ 0 };     // Updates finished
 
-        for (std::size_t i = 0; i + 1 < ant->route.size(); ++i) {
-            int a = ant->route[i]->id;
-            int b = ant->route[i + 1]->id;
+    thread updater([&] {
+        for (int k = 0; k < iterations; ++k) {
+            for (int r; (r = requested.load(memory_order_acquire)) <= k; ) {
+                requested.wait(r, memory_order_acquire);
+            }
+#pragma omp parallel num_threads(updaters)
+            updatePheromonesInTeam();
+            epoch.store(k + 1, memory_order_release);
+            epoch.notify_all();
+        }
+    });
 
-            pheromones[a][b] += concentration;
-            pheromones[b][a] += concentration;
+    enum AntTask { ConstructTour = 0, FinishTour = 1 };
+
+#pragma omp parallel num_threads(constructors)
+    {
+        const int worker = omp_get_thread_num();
+        const numa::ScopedPin pin = pinWorker(worker);
+
+        ConstructionWorkspace workspace;
+        workspace.choice = &pipelineChoice;
+
+        for (int it = 0; it < iterations; ++it) {
+            const uint64_t iteration = completedIterations + static_cast<uint64_t>(it);
+
+            // This set's last update finished before the previous handoff
+#pragma omp for schedule(static)
+            for (int k = 0; k < numAnts; ++k) {
+                pipelineAnts[k]->reset();
+            }
+
+#pragma omp single
+            scheduler->seedBlocks(numAnts, ConstructTour);
+
+            // Construction phase, overlapping the update of the previous iteration
+            scheduler->run(worker, [&](SchedulerTask task, int w) {
+                Ant& ant = *pipelineAnts[task.index];
+
+                if (task.kind == ConstructTour) {
+                    constructTour(ant, iteration, task.index, workspace);
+                    if (localSearch) {
+                        improveTour(ant, workspace);
+                    }
+                    scheduler->push(w, { FinishTour, task.index });
+                }
+                else {
+                    bestTours.offer(ant.routeLength, iteration * numAnts + task.index, ant.route);
+                }
+            });
+#pragma omp barrier
+
+            // Handoff: publish the previous update's choice information, queue this iteration's update
+#pragma omp single
+            {
+                bestTours.reclaim(); // This iteration's offers are done, the updater makes none
+                for (int e; (e = epoch.load(memory_order_acquire)) < it; ) {
+                    epoch.wait(e, memory_order_acquire);
+                }
+                std::swap(choiceInfo, pipelineChoice);
+                std::swap(ants, pipelineAnts);
+                requested.store(it + 1, memory_order_release);
+                requested.notify_one();
+            }
         }
     }
+
+    updater.join();
+
+    // Every handoff swapped the sets; after an odd number put the primary buffers back in place.
+    // The last update wrote the current choice information into whichever buffer was choiceInfo
+    if (iterations % 2 != 0) {
+        std::swap(choiceInfo, pipelineChoice);
+        std::swap(ants, pipelineAnts);
+        choiceInfo.copyFrom(pipelineChoice);
+    }
+    // Both sets still hold finished tours; a later run must start from empty ants
+    for (int k = 0; k < numAnts; ++k) {
+        ants[k]->reset();
+        pipelineAnts[k]->reset();
+    }
+
+    completedIterations += static_cast<uint64_t>(iterations);
+}
+
+void ACO::antUniforms(uint64_t iteration, int ant, float* out, size_t count) const {
+    const uint32_t key[2] = { seed, 0x41434F00u };
+    const uint32_t tail[3] = { static_cast<uint32_t>(ant), static_cast<uint32_t>(iteration),
+                               static_cast<uint32_t>(iteration >> 32) };
+    kernels::active().philoxUniforms(key, tail, out, count);
 }
 
 /*
- * Chooses the next city for the ant to visit
+ * Builds a complete tour for ant number antIndex of the given iteration
+ * - The start city and every roulette draw come from Philox keyed by (seed, iteration,
+ *   ant, step), so the tour does not depend on which thread builds it or when
+ * - All of the tour's draws are generated up front, 8 or 16 Philox blocks per SIMD pass,
+ *   so the selection loop only reads the next float
  */
-int ACO::selectNextCity(shared_ptr<Ant> ant, vector<float>* localProbRow, float random01) {
-    vector<int> feasibleCityIndexes;
-    feasibleCityIndexes.reserve(citys.size());
-    
-    for (size_t i = 0; i < citys.size(); ++i){
-        if (!ant->hasVisited(citys[i]->id)) {
-            feasibleCityIndexes.push_back(static_cast<int>(i));
-        }
+void ACO::constructTour(Ant& ant, uint64_t iteration, int antIndex, ConstructionWorkspace& workspace) {
+    const int routeSize = static_cast<int>(citys.size()) + 1;
+    const int num = static_cast<int>(citys.size());
+
+    if (workspace.uniforms.size() < static_cast<size_t>(routeSize)) {
+        workspace.uniforms.resize(routeSize);
     }
+    const float* draws = workspace.uniforms.data();
+    antUniforms(iteration, antIndex, workspace.uniforms.data(), routeSize);
 
-    if (feasibleCityIndexes.empty()) {
-        feasibleCityIndexes.push_back(ant->route[0]->id); // visit starting city
+    ant.visitCity(std::min(static_cast<int>(draws[0] * num), num - 1));
+    for (int step = 1; static_cast<int>(ant.route.size()) < routeSize; ++step) {
+        constructAntSolutions(ant, selectNextCity(ant, &workspace, draws[step]));
     }
+}
 
-    // Probability function call
-    updateProbablity(ant, feasibleCityIndexes,localProbRow);
+/*
+ * Hogwild variant of run(): no barrier anywhere
+ * - The same budget as run(), maxIterations * ants tours, is handed out through an atomic counter
+ * - A finished ant deposits Q / length straight into tau, clamped to maxPheromone, and refreshes
+ *   the choice information of the edges it touched
+ * - Evaporation is lazy: tour t belongs to epoch t / ants + 1 and row i stores
+ *   tau * keep^-(epoch - rowEpochs[i]), so an epoch's evaporation costs nothing and a deposit
+ *   adds Q / length scaled by the same factor. The factor is common to the whole row, so the
+ *   roulette over a row picks as if the row were evaporated. A row is renormalized (multiplied
+ *   out, clamped, its epoch advanced) only once that factor would pass 2^lazyScaleBits, and every
+ *   row is multiplied out when the run ends
+ * - A deposit holds its row for one cell: rowEpochs[i] doubles as the row's lock (busy while
+ *   held), so a deposit never races a renormalization of the same row and tau needs no atomics
+ * - Tour construction reads choiceInfo through relaxed atomic loads (see snapshotChoice) while
+ *   the row holder stores into it; values may be stale, which is the Hogwild trade, never torn
+ */
+void ACO::runAsynchronous() {
+    const int threads = teamSize();
+    const int numAnts = static_cast<int>(ants.size());
+    const int num = static_cast<int>(citys.size());
+    const int64_t budget = static_cast<int64_t>(maxIterations) * numAnts;
+    if (budget <= 0 || num < 2) {
+        return;
+    }
+
+    const float keep = 1.0f - evaporationRate;
+    // Epochs a row may fall behind before its scale factor keep^-behind passes 2^lazyScaleBits
+    const int64_t maxBehind = keep <= 0.0f ? 0
+        : keep >= 1.0f ? numeric_limits<int64_t>::max()
+        : static_cast<int64_t>(lazyScaleBits / -std::log2(keep));
+    constexpr int64_t busy = -1;
+    vector<int64_t> rowEpochs(num, 0);
 
-    struct cityIndexProb {
-        int cityId;
-        float prob;
+    // keep^epochs as a float
+    auto decay = [keep](int64_t epochs) {
+        return epochs == 0 ? 1.0f : static_cast<float>(std::pow(static_cast<double>(keep), static_cast<double>(epochs)));
     };
 
-    struct
+    // Takes row i, returning the epoch its stored values are exact at
+    auto lockRow = [&](int i) {
+        atomic_ref<int64_t> epoch(rowEpochs[i]);
+        int64_t exactAt = epoch.load(memory_order_relaxed);
+        while (exactAt == busy || !epoch.compare_exchange_weak(exactAt, busy, memory_order_acquire)) {
+            if (exactAt == busy) {
+                this_thread::yield();
+                exactAt = epoch.load(memory_order_relaxed);
+            }
+        }
+        return exactAt;
+    };
+
+    // Multiplies the held row i out from epoch exactAt to target and returns the new exact epoch
+    auto renormalize = [&](int i, int64_t exactAt, int64_t target) {
+        if (target <= exactAt) {
+            return exactAt;
+        }
+        const float factor = decay(target - exactAt);
+        float* tau = pheromones.row(i);
+        float* choice = choiceInfo.row(i);
+        const float* eta = heuristics.row(i);
+        for (int j = 0; j < num; ++j) {
+            tau[j] = std::clamp(tau[j] * factor, minPheromone, maxPheromone);
+            atomic_ref<float>(choice[j]).store(weightKernel->pheromoneWeight(tau[j], alpha) * eta[j], memory_order_relaxed);
+        }
+        return target;
+    };
+
+    atomic<int64_t> nextTour{ 0 };
+
+#pragma omp parallel num_threads(threads)
     {
-        bool operator()(cityIndexProb a, cityIndexProb b) const {
-          return a.prob < b.prob;
+        const int worker = omp_get_thread_num();
+        const numa::ScopedPin pin = pinWorker(worker);
+        ConstructionWorkspace workspace;
+        workspace.atomicReads = true;
+        Ant ant(worker, citys.size());
+
+        for (int64_t tour; (tour = nextTour.fetch_add(1, memory_order_relaxed)) < budget; ) {
+            const uint64_t iteration = completedIterations + static_cast<uint64_t>(tour / numAnts);
+            const int64_t epoch = tour / numAnts + 1; // This iteration's evaporation precedes its deposits
+            constructTour(ant, iteration, static_cast<int>(tour % numAnts), workspace);
+            if (localSearch) {
+                improveTour(ant, workspace);
+            }
+
+            // Deposit: clamped compare-and-swap adds in each row's scale, then refresh choice info
+            // of both directions
+            const float concentration = Q / ant.routeLength;
+            for (size_t k = 0; k + 1 < ant.route.size(); ++k) {
+                const int a = ant.route[k];
+                const int b = ant.route[k + 1];
+                for (int side = 0; side < 2; ++side) {
+                    const int from = side == 0 ? a : b;
+                    const int to = side == 0 ? b : a;
+                    int64_t exactAt = lockRow(from);
+                    if (epoch - exactAt > maxBehind) {
+                        exactAt = renormalize(from, exactAt, epoch);
+                    }
+                    // A row already exact past this tour's epoch takes the deposit unscaled
+                    const float scale = 1.0f / decay(std::max<int64_t>(epoch - exactAt, 0));
+                    float& tau = pheromones.row(from)[to];
+                    tau = std::min(tau + concentration * scale, maxPheromone * scale);
+                    const float choice = weightKernel->pheromoneWeight(tau, alpha) * heuristics.row(from)[to];
+                    atomic_ref<float>(choiceInfo.row(from)[to]).store(choice, memory_order_relaxed);
+                    atomic_ref<int64_t>(rowEpochs[from]).store(exactAt, memory_order_release);
+                }
+            }
+
+            bestTours.offer(ant.routeLength, iteration * numAnts + tour % numAnts, ant.route);
+            ant.reset();
+        }
+
+        // Every row owes the evaporation of the epochs since it was last exact
+#pragma omp barrier
+#pragma omp for schedule(static)
+        for (int i = 0; i < num; ++i) {
+            rowEpochs[i] = renormalize(i, rowEpochs[i], static_cast<int64_t>(maxIterations));
         }
     }
-    CIPsort;
+    bestTours.reclaim(); // Offers never pause inside the run, so this is its only quiescent point
 
-    // Track probabilities with city id
-    vector<cityIndexProb> cityProbabilities;
-    cityProbabilities.reserve(feasibleCityIndexes.size());
+    completedIterations += static_cast<uint64_t>(maxIterations);
+}
 
-    for (int i : feasibleCityIndexes) {
-        float p = localProbRow
-            ? (*localProbRow)[i]
-            : probablitys[ant->currCity->id][i];
-        cityProbabilities.push_back({i,p});
+/*
+ * Deposits an immigrant tour from another colony
+ * - Both directions of every edge get weight * Q / length, clamped to maxPheromone
+ * - The choice information is refreshed so the next construction sees it
+ */
+void ACO::reinforceTour(const vector<int>& route, float length, float weight) {
+    if (route.size() < 2 || !(length > 0.0f)) {
+        return;
     }
 
-    std::sort(cityProbabilities.begin(), cityProbabilities.end(), CIPsort);
-  
-    // Calculate total of all city probabilities
-    float total = 0.0f;
-    for (const auto& prob : cityProbabilities) {
-        total += prob.prob;
+    const float amount = weight * Q / length;
+    for (size_t k = 0; k + 1 < route.size(); ++k) {
+        int a = route[k];
+        int b = route[k + 1];
+        pheromones.row(a)[b] = std::min(pheromones.row(a)[b] + amount, maxPheromone);
+        pheromones.row(b)[a] = std::min(pheromones.row(b)[a] + amount, maxPheromone);
     }
 
-    if (total <= 0.0f) {
-        // choose uniformly among feasible cities
-        int n = static_cast<int>(feasibleCityIndexes.size());
-        if (n == 1) {
-            return cityProbabilities[0].cityId;
+    computeChoiceInformation();
+}
+
+/*
+ * Mixes the pheromone matrices of other colonies into this one
+ * - tau = (1 - weight) * tau + weight * average(source tau), row by row
+ * - Sources must have the same shape and must not change during the call
+ */
+void ACO::blendPheromones(const vector<const AlignedMatrix*>& sources, float weight) {
+    if (sources.empty()) {
+        return;
+    }
+
+    const int num = static_cast<int>(citys.size());
+    const float keep = 1.0f - weight;
+    const float share = weight / static_cast<float>(sources.size());
+
+    backend->forEach(num, [&](int i) {
+        float* tau = pheromones.row(i);
+        for (int j = 0; j < num; ++j) {
+            tau[j] *= keep;
+        }
+        for (const AlignedMatrix* source : sources) {
+            const float* other = source->row(i);
+            for (int j = 0; j < num; ++j) {
+                tau[j] += share * other[j];
+            }
+        }
+        for (int j = 0; j < num; ++j) {
+            tau[j] = std::clamp(tau[j], minPheromone, maxPheromone);
+        }
+    });
+
+    computeChoiceInformation();
+}
+
+/*
+ * Picks the unvisited city with the largest choice information
+ * - Returns -1 when every city has been visited
+ */
+int ACO::bestUnvisitedCity(const Ant& ant, ConstructionWorkspace& workspace, const float* choice) {
+    const int num = static_cast<int>(citys.size());
+    if (num >= parallelSelectionThreshold) {
+        runStepScan(StepScan::BestUnvisited, ant, choice, workspace);
+
+        // First strictly larger chunk best, so ties go to the lowest city like the loop below
+        int best = -1;
+        float bestValue = -1.0f;
+        const int chunks = (num + selectionChunk - 1) / selectionChunk;
+        for (int c = 0; c < chunks; ++c) {
+            if (workspace.chunkFeasible[c] >= 0 && workspace.chunkTotals[c] > bestValue) {
+                bestValue = workspace.chunkTotals[c];
+                best = workspace.chunkFeasible[c];
+            }
         }
-        if (random01 < 0.0f) {
-            std::uniform_int_distribution<int> dist(0, n - 1);
-            return feasibleCityIndexes[dist(rng)];
+        return best;
+    }
+
+    int best = -1;
+    float bestValue = -1.0f;
+
+    for (int j = 0; j < num; ++j) {
+        if (choice[j] > bestValue && !ant.hasVisited(j)) {
+            bestValue = choice[j];
+            best = j;
+        }
+    }
+    return best;
+}
+
+/*
+ * Chooses the next city for the ant to visit
+ * - Samples among the unvisited cities of the current city's candidate list
+ * - Falls back to the best unvisited city when every candidate is taken
+ * - Roulette wheel in two linear passes: gather weights and their total, then
+ *   walk the running sum up to random01 * total (no sort, no normalization)
+ */
+/*
+ * Copies the entries of a choice row a step reads (the given candidates, or the whole row when
+ * candidates is null) with relaxed atomic loads, for steps whose row other threads store into
+ * - snapshot must already hold a whole row
+ */
+static const float* snapshotChoice(const float* row, const int* candidates, int count, vector<float>& snapshot) {
+    float* out = snapshot.data();
+    float* cells = const_cast<float*>(row);
+    if (candidates) {
+        for (int k = 0; k < count; ++k) {
+            // The candidate's own index, so the gather kernels read the copy like the row
+            out[candidates[k]] = atomic_ref<float>(cells[candidates[k]]).load(memory_order_relaxed);
         }
-        else {
-            int k = static_cast<int>(random01 * n);
-            if (k >= n) k = n - 1;
-            return feasibleCityIndexes[k];
+    }
+    else {
+        for (int j = 0; j < count; ++j) {
+            out[j] = atomic_ref<float>(cells[j]).load(memory_order_relaxed);
+        }
+    }
+    return out;
+}
+
+int ACO::selectNextCity(Ant& ant, ConstructionWorkspace* workspace, float random01) {
+    ConstructionWorkspace& ws = workspace ? *workspace : sequentialWorkspace;
+    if (ws.weights.size() < static_cast<size_t>(nnListSize)) {
+        ws.weights.resize(nnListSize);
+    }
+
+    const kernels::KernelTable& simd = kernels::active();
+    const int* candidates = nearestNeighbors.data() + static_cast<size_t>(ant.currCity) * nnListSize;
+    const float* row = (ws.choice ? ws.choice : &choiceInfo)->row(ant.currCity);
+    float* weights = ws.weights.data();
+
+    // Pass 1: weight of each candidate, zero once visited
+    // Long rows are gathered chunk by chunk (by the ant's team if it has one) and summed in chunk order
+    const bool chunked = nnListSize >= parallelSelectionThreshold;
+    const int chunks = (nnListSize + selectionChunk - 1) / selectionChunk;
+    const int num = static_cast<int>(citys.size());
+    if (ws.atomicReads && ws.snapshot.size() < static_cast<size_t>(num)) {
+        ws.snapshot.resize(num);
+    }
+    const float* choice = ws.atomicReads ? snapshotChoice(row, candidates, nnListSize, ws.snapshot) : row;
+    int feasible = 0;
+    float total = 0.0f;
+    if (chunked) {
+        runStepScan(StepScan::Weights, ant, choice, ws);
+        for (int c = 0; c < chunks; ++c) {
+            total += ws.chunkTotals[c];
+            feasible += ws.chunkFeasible[c];
+        }
+    }
+    else {
+        total = simd.gatherWeights(choice, candidates, ant.visitedBits.data(), nnListSize, weights, &feasible);
+    }
+
+    if (feasible == 0) {
+        if (ws.atomicReads) {
+            choice = snapshotChoice(row, nullptr, num, ws.snapshot);
         }
+        int best = bestUnvisitedCity(ant, ws, choice);
+        return best >= 0 ? best : ant.route.front(); // visit starting city once all are visited
+    }
+
+    if (!workspace) {
+        updateProbablity(ant, weights, total);
     }
 
-    // Get random value in 0 to total
     float u = random01;
     if (u < 0.0f) {
         u = std::uniform_real_distribution<float>(0.0f, 1.0f)(rng);
     }
-    float randomValue = u * total;
 
-    float cumulativeProbability = 0.0f;
-    for (const auto& prob : cityProbabilities) {
-        cumulativeProbability += prob.prob;
-        if (cumulativeProbability >= randomValue) {
-            return prob.cityId;
+    if (total <= 0.0f) {
+        // choose uniformly among feasible candidates
+        int pick = std::min(static_cast<int>(u * feasible), feasible - 1);
+        for (int k = 0; k < nnListSize; ++k) {
+            if (!ant.hasVisited(candidates[k]) && pick-- == 0) {
+                return candidates[k];
+            }
+        }
+    }
+
+    // Pass 2: walk the running sum until it reaches u * total
+    // Chunked rows skip whole chunks on their totals and search only the chunk that crosses the target
+    float target = u * total;
+    if (chunked) {
+        for (int c = 0; c < chunks; ++c) {
+            if (ws.chunkTotals[c] > 0.0f && ws.chunkTotals[c] >= target) {
+                const int begin = c * selectionChunk;
+                int picked = simd.rouletteSearch(weights + begin, std::min(selectionChunk, nnListSize - begin), target);
+                if (picked >= 0) {
+                    return candidates[begin + picked];
+                }
+                break;
+            }
+            target -= ws.chunkTotals[c];
+        }
+    }
+    else {
+        int picked = simd.rouletteSearch(weights, nnListSize, target);
+        if (picked >= 0) {
+            return candidates[picked];
+        }
+    }
+
+    // Default return in case of a rounding error: last candidate with any weight
+    for (int k = nnListSize - 1; k > 0; --k) {
+        if (weights[k] > 0.0f) {
+            return candidates[k];
+        }
+    }
+    return candidates[0];
+}
+
+/*
+ * Scans this member's chunks of a long row into the workspace's per-chunk results
+ * - Weights: gathers candidate weights of chunk c into weights[c * selectionChunk ...]
+ *   and records their sum and unvisited count
+ * - BestUnvisited: records the first unvisited city with the largest choice value in chunk c
+ */
+void ACO::scanChunks(StepScan scan, const Ant& ant, const float* row, ConstructionWorkspace& workspace,
+                     int member, int members) {
+    const int length = scan == StepScan::Weights ? nnListSize : static_cast<int>(citys.size());
+    const int chunks = (length + selectionChunk - 1) / selectionChunk;
+
+    if (scan == StepScan::Weights) {
+        const kernels::KernelTable& simd = kernels::active();
+        const int* candidates = nearestNeighbors.data() + static_cast<size_t>(ant.currCity) * nnListSize;
+        for (int c = member; c < chunks; c += members) {
+            const int begin = c * selectionChunk;
+            int feasible = 0;
+            workspace.chunkTotals[c] = simd.gatherWeights(row, candidates + begin, ant.visitedBits.data(),
+                                                          std::min(selectionChunk, length - begin),
+                                                          workspace.weights.data() + begin, &feasible);
+            workspace.chunkFeasible[c] = feasible;
+        }
+    }
+    else if (scan == StepScan::BestUnvisited) {
+        for (int c = member; c < chunks; c += members) {
+            const int end = std::min(length, (c + 1) * selectionChunk);
+            int best = -1;
+            float bestValue = -1.0f;
+            for (int j = c * selectionChunk; j < end; ++j) {
+                if (row[j] > bestValue && !ant.hasVisited(j)) {
+                    bestValue = row[j];
+                    best = j;
+                }
+            }
+            workspace.chunkTotals[c] = bestValue;
+            workspace.chunkFeasible[c] = best;
         }
     }
+}
+
+/*
+ * Leader side of a long-row scan
+ * - Without a team (or with a team of one) the chunks are scanned here in order
+ * - Otherwise the scan is posted, everyone takes their chunks, and the second barrier
+ *   phase guarantees every chunk result is written before the leader reduces them
+ */
+void ACO::runStepScan(StepScan scan, const Ant& ant, const float* row, ConstructionWorkspace& workspace) {
+    const int chunks = (static_cast<int>(citys.size()) + selectionChunk - 1) / selectionChunk;
+    if (workspace.chunkTotals.size() < static_cast<size_t>(chunks)) {
+        workspace.chunkTotals.resize(chunks);
+        workspace.chunkFeasible.resize(chunks);
+    }
+
+    StepTeam* team = workspace.team;
+    if (!team || team->size == 1) {
+        scanChunks(scan, ant, row, workspace, 0, 1);
+        return;
+    }
+
+    (scan == StepScan::Weights ? teamWeightScans : teamBestUnvisitedScans).fetch_add(1, memory_order_relaxed);
+    team->scan = scan;
+    team->ant = &ant;
+    team->row = row;
+    team->workspace = &workspace;
+    team->sync.arrive_and_wait();
+    scanChunks(scan, ant, row, workspace, 0, team->size);
+    team->sync.arrive_and_wait();
+}
+
+/*
+ * Helper loop of a StepTeam member
+ * - Finish also goes through both barrier phases, so the leader cannot post the next
+ *   tour's first scan before every helper has read Finish
+ */
+void ACO::assistStepTeam(StepTeam& team, int member) {
+    for (;;) {
+        team.sync.arrive_and_wait();
+        const StepScan scan = team.scan;
+        if (scan != StepScan::Finish) {
+            scanChunks(scan, *team.ant, team.row, *team.workspace, member, team.size);
+        }
+        team.sync.arrive_and_wait();
+        if (scan == StepScan::Finish) {
+            return;
+        }
+    }
+}
+
+void ACO::finishStepTeam(ConstructionWorkspace& workspace) {
+    StepTeam* team = workspace.team;
+    if (!team || team->size == 1) {
+        return;
+    }
+    team->scan = StepScan::Finish;
+    team->sync.arrive_and_wait();
+    team->sync.arrive_and_wait();
+}
+
+/*
+ * Applies pheromone changes received from another colony
+ * - Each delta is added to both directions of its edge and clamped to [minPheromone, maxPheromone]
+ * - Out-of-range edges (a peer solving a different instance) are ignored
+ */
+void ACO::applyPheromoneDeltas(const vector<EdgeDelta>& deltas, float weight) {
+    const uint64_t n = citys.size();
+    if (deltas.empty()) {
+        return;
+    }
+
+    for (const EdgeDelta& delta : deltas) {
+        if (delta.edge >= n * n) {
+            continue;
+        }
+        size_t i = static_cast<size_t>(delta.edge / n);
+        size_t j = static_cast<size_t>(delta.edge % n);
+        float amount = weight * delta.amount;
+        pheromones.row(i)[j] = std::clamp(pheromones.row(i)[j] + amount, minPheromone, maxPheromone);
+        pheromones.row(j)[i] = std::clamp(pheromones.row(j)[i] + amount, minPheromone, maxPheromone);
+    }
+
+    computeChoiceInformation();
+}
 
-    // Default return in case of a rounding error
-    return cityProbabilities.back().cityId;
+/*
+ * Parallel first touch
+ * - The matrix is allocated untouched, then every row (padding included) is written by the
+ *   thread that owns it under schedule(static), the same partition the update sweep uses
+ */
+void ACO::firstTouch(AlignedMatrix& matrix, size_t rows, size_t cols, float value) {
+    matrix.allocate(rows, cols);
+    const size_t stride = matrix.stride();
+
+#pragma omp parallel num_threads(teamSize())
+    {
+        const numa::ScopedPin pin = pinWorker(omp_get_thread_num());
+
+#pragma omp for schedule(static)
+        for (int i = 0; i < static_cast<int>(rows); ++i) {
+            float* row = matrix.row(i);
+            std::fill(row, row + cols, value);
+            std::fill(row + cols, row + stride, 0.0f);
+        }
+    }
+}
+
+/*
+ * Re-places a matrix by copying it into a fresh allocation with the current team
+ * - The object stays the same, so references held elsewhere (GUI) remain valid
+ */
+void ACO::rehome(AlignedMatrix& matrix) {
+    if (matrix.paddedSize() == 0) {
+        return;
+    }
+    AlignedMatrix fresh;
+    fresh.allocate(matrix.rows(), matrix.cols());
+    const size_t stride = matrix.stride();
+
+#pragma omp parallel num_threads(teamSize())
+    {
+        const numa::ScopedPin pin = pinWorker(omp_get_thread_num());
+
+#pragma omp for schedule(static)
+        for (int i = 0; i < static_cast<int>(matrix.rows()); ++i) {
+            std::copy(matrix.row(i), matrix.row(i) + stride, fresh.row(i));
+        }
+    }
+    matrix = std::move(fresh);
+}
+
+/*
+ * Applies a pinning plan
+ * - Records each thread's node and its rank within that node's threads (for replica refresh)
+ * - Re-places the matrices the hot loops sweep, then rebuilds the replicas
+ */
+void ACO::setThreadPinning(const vector<int>& cpus) {
+    pinnedCpus = cpus;
+    workerNode.assign(cpus.size(), 0);
+    workerNodeRank.assign(cpus.size(), 0);
+    nodeThreads.assign(numa::nodeCount(), 0);
+    for (size_t t = 0; t < cpus.size(); ++t) {
+        int node = std::min(numa::nodeOfCpu(cpus[t]), numa::nodeCount() - 1);
+        workerNode[t] = node;
+        workerNodeRank[t] = nodeThreads[node]++;
+    }
+
+    if (!pinnedCpus.empty()) {
+        rehome(pheromones);
+        rehome(proximitys);
+        rehome(heuristics);
+        rehome(choiceInfo);
+    }
+    prepareReplicas();
+}
+
+void ACO::setNumaReplicas(bool enabled) {
+    numaReplicas = enabled;
+    prepareReplicas();
+}
+
+/*
+ * Replicas only pay off when the pinned team spans several nodes
+ * - Allocated untouched here; the first refreshReplica writes each one from its own node
+ */
+void ACO::prepareReplicas() {
+    choiceReplicas.clear();
+    int nodesUsed = 0;
+    for (int count : nodeThreads) {
+        nodesUsed += count > 0;
+    }
+    if (!numaReplicas || pinnedCpus.empty() || nodesUsed < 2) {
+        return;
+    }
+
+    choiceReplicas.resize(nodeThreads.size());
+    for (size_t node = 0; node < nodeThreads.size(); ++node) {
+        if (nodeThreads[node] > 0) {
+            choiceReplicas[node].allocate(choiceInfo.rows(), choiceInfo.cols());
+        }
+    }
+}
+
+void ACO::refreshReplica(int worker) {
+    const size_t n = choiceInfo.rows();
+    const size_t stride = choiceInfo.stride();
+    const int node = workerNode[worker];
+    const size_t group = static_cast<size_t>(nodeThreads[node]);
+    const size_t rank = static_cast<size_t>(workerNodeRank[worker]);
+    AlignedMatrix& replica = choiceReplicas[node];
+
+    for (size_t i = rank * n / group; i < (rank + 1) * n / group; ++i) {
+        std::copy(choiceInfo.row(i), choiceInfo.row(i) + stride, replica.row(i));
+    }
+#pragma omp barrier
+}
+
+void ACO::printPlacementReport(ostream& out) const {
+    const int nodes = numa::nodeCount();
+    out << "NUMA: " << nodes << " node(s), ";
+    if (pinnedCpus.empty()) {
+        out << "threads not pinned\n";
+    }
+    else {
+        out << "threads pinned to cpus";
+        for (int cpu : pinnedCpus) {
+            out << " " << cpu;
+        }
+        out << "\n";
+    }
+
+    auto reportMatrix = [&](const char* name, const AlignedMatrix& matrix) {
+        vector<size_t> pages = numa::pagesPerNode(matrix.data(), matrix.paddedSize() * sizeof(float));
+        out << "  " << name << ": ";
+        if (pages.empty()) {
+            out << "placement unavailable\n";
+            return;
+        }
+        size_t total = 0;
+        for (size_t count : pages) {
+            total += count;
+        }
+        for (int node = 0; node < nodes; ++node) {
+            out << "node " << node << " " << pages[node] << " pages, ";
+        }
+        out << "untouched " << pages[nodes] << " of " << total << "\n";
+    };
+
+    reportMatrix("pheromones", pheromones);
+    reportMatrix("proximitys", proximitys);
+    reportMatrix("heuristics", heuristics);
+    reportMatrix("choiceInfo", choiceInfo);
+    for (size_t node = 0; node < choiceReplicas.size(); ++node) {
+        if (choiceReplicas[node].paddedSize() > 0) {
+            string name = "choiceInfo replica " + to_string(node);
+            reportMatrix(name.c_str(), choiceReplicas[node]);
+        }
+    }
 }
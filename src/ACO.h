@@ -2,105 +2,454 @@
 #define ACO_H
 
 #include "Ant.h"
+#include "AlignedMatrix.h"
+#include "Weights.h"
+#include "WorkStealing.h"
+#include "Numa.h"
+#include "Philox.h"
+#include "BestTour.h"
+#include "ExecutionBackend.h"
 
+#include <barrier>
 
 using namespace std;
 
-// Namespace containing constants for the ACO algorithm
-namespace constants {
-    extern float alpha; // Importance of pheromone
-    extern float beta;  // Importance of heuristic information
-}
+// How the per-iteration pheromone deposit is spread over threads
+enum class DepositStrategy {
+    Auto,       // SortReduce, the only strategy whose result does not depend on the team
+    Sequential, // Single thread, pre-scaled in-place adds; opt-in, rounds differently from SortReduce
+    SortReduce, // Per-thread edge-delta lists bucketed by row, sorted and reduced by their owner thread
+    Atomic      // Atomic float adds straight into the pheromone matrix; opt-in, sums in arrival order
+};
+
+// One pheromone deposit on the undirected edge (a, b) with a < b, keyed as a * n + b
+struct EdgeDelta {
+    uint64_t edge;
+    float amount;
+    uint32_t ant = 0; // Depositing ant, orders equal edges in sort-reduce
+};
+
+struct StepTeam;
+
+// Scratch space for one thread's tour construction
+// Sized on first use and reused every step, so selection never allocates
+struct ConstructionWorkspace {
+    vector<float> weights; // Selection weight of each candidate of the current city
+    vector<float> uniforms; // Every draw of the current tour, generated before construction starts
+    const AlignedMatrix* choice = nullptr; // Node-local copy of the choice information, null for the shared one
+    StepTeam* team = nullptr; // Threads that help scan long rows, null when the ant is built alone
+    vector<int> tour;     // Local search: the tour being improved, without the repeated start city
+    vector<int> position; // Local search: index of every city in tour
+    // runAsynchronous(): other threads store into choiceInfo while this ant reads it, so a step
+    // copies the entries it needs with relaxed atomic loads into snapshot and selects from that
+    bool atomicReads = false;
+    vector<float> snapshot;
+
+    // Per-chunk results of a long-row scan (see ACO::selectionChunk)
+    vector<float> chunkTotals;  // Weight sum, or best choice value for a best-unvisited scan
+    vector<int> chunkFeasible;  // Unvisited candidates, or index of the best unvisited city (-1 if none)
+};
+
+// What the members of a StepTeam scan at the current step
+enum class StepScan {
+    Weights,       // Candidate weights of the current city
+    BestUnvisited, // Best unvisited city by choice information
+    Finish         // Tour done, helpers leave
+};
+
+// Threads sharing one ant's tour on instances with fewer ants than threads
+// The leader builds the tour; whenever a step has to scan a long row it posts the scan and
+// every member (leader included) takes chunks member, member + size, ... of it, then the
+// leader reduces the per-chunk results in chunk order. Chunks are fixed-size, so the pick
+// is the same whatever the team size
+struct StepTeam {
+    explicit StepTeam(int members) : size(members), sync(members) {}
+
+    int size;
+    barrier<> sync; // Two phases per scan: posted, then scanned
+
+    // Posted by the leader before each scan
+    StepScan scan = StepScan::Finish;
+    const Ant* ant = nullptr;
+    const float* row = nullptr;
+    ConstructionWorkspace* workspace = nullptr; // The leader's, every member writes its chunks there
+};
 
-// Random number generator, only for sequential
-inline mt19937 rng(static_cast<unsigned>(time(nullptr)));
+// Wall-clock seconds of each phase of the ACO constructor
+struct StartupTimings {
+    double distances = 0.0;      // Proximity matrix (and GUI probability matrix)
+    double heuristics = 0.0;
+    double candidateLists = 0.0;
+    double pheromones = 0.0;
+    double choiceInfo = 0.0;
+    double total = 0.0;
+};
 
 // A class representing the Ant Colony Optimization algorithm
 class ACO {
 public:
 
     // Constructor to initialize ACO with cities, number of ants, and maxIterations(wont be used rn)
-    ACO(vector<shared_ptr<city>>& inCitys, int amtAnts, float newQ, float newER)
-        : pheromones(inCitys.size(), vector<float>(inCitys.size(), 1.0f)),
-        citys(inCitys),
+    // candidateListSize is how many nearest neighbours each city considers (<= 0 means all cities)
+    // With all cities on an instance of at least the parallel-selection threshold, every step's
+    // weight scan is long enough to be split over a StepTeam; with a short list only the
+    // best-unvisited fallback is
+    ACO(vector<shared_ptr<city>>& inCitys, int amtAnts, float newQ, float newER, int candidateListSize = 20)
+        : evaporationRate(newER),
         Q(newQ),
-        evaporationRate(newER),
-        maxIterations(0) {
+        citys(inCitys),
+        maxIterations(0),
+        seed(static_cast<unsigned>(time(nullptr))),
+        rng(seed),
+        weightKernel(&weights::selectKernel(alpha, beta)) {
 
         // Create ant instances and assign IDs
         ants.resize(amtAnts);
         for (int i = 0; i < amtAnts; ++i) {
-            ants[i] = make_shared<Ant>(i);
+            ants[i] = make_shared<Ant>(i, inCitys.size());
             ants[i]->id = i;
         }
 
-        initializeParameters();
-        initializePheromoneTrails();
+        initializeInstance(candidateListSize);
     }
 
+    // Changing alpha invalidates the cached choice information
+    // Only this instance is affected, solvers running on other threads keep their own
     void setAlpha(float newVal){
-      constants::alpha = newVal;
+      alpha = newVal;
+      weightKernel = &weights::selectKernel(alpha, beta);
+      computeChoiceInformation();
     }
 
-
+    // Changing beta invalidates both the heuristic and choice information
     void setBeta(float newVal){
-      constants::beta = newVal;
+      beta = newVal;
+      weightKernel = &weights::selectKernel(alpha, beta);
+      computeHeuristicInformation();
+      computeChoiceInformation();
+    }
+
+    float getAlpha() const { return alpha; }
+    float getBeta() const { return beta; }
+
+    // Reseeds this instance: the GUI generator and the Philox key of run()
+    void setSeed(unsigned newSeed){
+      seed = newSeed;
+      rng.seed(seed);
+    }
+
+    // Forces sort-reduce deposits even when depositStrategy asks for Sequential or Atomic;
+    // the default (Auto) already gives bit-identical tours and pheromones for any thread count
+    void setDeterministic(bool enabled){
+      deterministic = enabled;
+    }
+
+    // Threads used by run() and the backend; 0 means the OpenMP default
+    void setThreadCount(int threads){
+      numThreads = threads;
+      backend = makeExecutionBackend(backend->kind(), numThreads);
+    }
+
+    // Execution model of run(), updatePheromones() and the whole-matrix loops, picked at run time
+    // OpenMP (the default) runs iterations on the persistent work-stealing team with pinning
+    // and NUMA replicas; any other backend runs them phase by phase through runOnBackend.
+    // runPipelined() and runAsynchronous() always schedule their own OpenMP teams
+    void setExecutionBackend(BackendKind kind){
+      backend = makeExecutionBackend(kind, numThreads);
     }
 
+    const ExecutionBackend& getExecutionBackend() const {
+      return *backend;
+    }
+
+    // Improve every tour with candidate-list 2-opt before it is deposited
+    void setLocalSearch(bool enabled){
+      localSearch = enabled;
+    }
+
+    // Threads of runPipelined() that apply pheromone updates (taken from the team size);
+    // 0 means a quarter of the team, at least one
+    void setUpdaterThreads(int threads){
+      updaterThreads = threads;
+    }
+
+    // Rows at least this long (candidates, or cities for the best-unvisited fallback) are
+    // scanned in selectionChunk pieces, and run() gives ants StepTeams when it has more threads
+    // than ants on instances of at least this many cities
+    void setParallelSelectionThreshold(int length){
+      parallelSelectionThreshold = std::max(length, 4);
+      selectionChunk = parallelSelectionThreshold / 4;
+    }
+
+    // Long-row scans of the given kind that a StepTeam of more than one thread shared
+    uint64_t getTeamScans(StepScan scan) const {
+      return scan == StepScan::Weights ? teamWeightScans.load() : teamBestUnvisitedScans.load();
+    }
+
+    // Pins the threads of this instance's teams (thread t to cpus[t % size]) and re-places
+    // the matrices with the pinned team, so each row's pages sit on the node that sweeps it
+    void setThreadPinning(const vector<int>& cpus);
+    void setThreadPinning(numa::PinningPolicy policy) {
+      setThreadPinning(numa::pinningPlan(policy, teamSize()));
+    }
+
+    // Per-node copies of the choice information for tour construction in run(), refreshed
+    // after every update; only used while threads are pinned across more than one node
+    void setNumaReplicas(bool enabled);
+
+    // Pinned CPUs and the node placement of every matrix's pages
+    void printPlacementReport(ostream& out) const;
+
     // Returns a reference to the vector of ant objects
     vector<shared_ptr<Ant>>& getAnts() {
         return ants;
     }
 
     // Returns a reference to the pheromone matrix
-    vector<vector<float>>& getPheromones() {
+    AlignedMatrix& getPheromones() {
         return pheromones;
     }
 
+    // Lower pheromone clamp, the value evaporation bottoms out at
+    float getMinPheromone() const {
+        return minPheromone;
+    }
+
     // Returns a reference to the proximity matrix
-    vector<vector<float>>& getProximity() {
+    AlignedMatrix& getProximity() {
         return proximitys;
     }
 
     // Returns a reference to the probability matrix
-    vector<vector<float>>& getProbablitys() {
+    AlignedMatrix& getProbablitys() {
         return probablitys;
     }
    
     // Perform a single step for the specified ant
-    void step(shared_ptr<Ant>& ant) {
-        ant->currCity = citys[selectNextCity(ant)];
+    void step(Ant& ant) {
+        constructAntSolutions(ant, selectNextCity(ant));
+    }
 
-        constructAntSolutions(ant);
+    // Extend the ant's solution by moving it to nextCity
+    void constructAntSolutions(Ant& ant, int nextCity) {
+        ant.visitCity(nextCity, proximitys.row(ant.currCity)[nextCity]);
     }
 
 
     void updatePheromones();
 
+    // Rebuild choiceInfo[i][j] = tau^alpha * eta^beta from the current pheromones
+    void computeChoiceInformation();
+
 
-    // Run the ACO algorithm
+    // Run the ACO algorithm for maxIterations iterations on the execution backend
+    // (a persistent thread team for OpenMP)
     void run();
 
+    // Asynchronous (Hogwild) run with the same tour budget: no barriers, every ant deposits
+    // with a compare-and-swap as soon as it finishes and evaporation is applied a stripe at a time
+    void runAsynchronous();
+
+    // The phased algorithm (construct, deposit, sweep) with every parallel loop run by the
+    // given backend, so the execution model can be picked at run time; pinning and NUMA
+    // replicas are left to the backend's threads
+    void runOnBackend(ExecutionBackend& backend);
+
+    // Pipelined run: iteration k + 1's ants are built on a snapshot of the choice information
+    // while a separate updater team applies iteration k's pheromone update, so ants see
+    // pheromones one iteration older than with run()
+    void runPipelined();
+
+    void setMaxIterations(int iterations) {
+        maxIterations = iterations;
+    }
+
+    // How long construction took, phase by phase
+    const StartupTimings& getStartupTimings() const {
+        return startupTimings;
+    }
+
+    // Shortest tour found by any run so far
+    float getBestLength() const {
+        const PublishedTour* best = bestTours.current();
+        return best ? best->length : numeric_limits<float>::max();
+    }
+
+    // City order of that tour, start city repeated at the end (empty before the first run)
+    // Valid until the next run on this instance
+    const vector<int>& getBestRoute() const {
+        static const vector<int> none;
+        const PublishedTour* best = bestTours.current();
+        return best ? best->route : none;
+    }
+
+    // Best-so-far register, updated after every tour; safe to read from any thread while
+    // a run is in progress (e.g. to monitor progress or decide to stop). Runs reclaim replaced
+    // tours between iterations, so a monitor keeping a current() pointer holds a ReadGuard
+    const BestTourRegister& getBestTours() const {
+        return bestTours;
+    }
+
+    // Migration: deposits weight * Q / length on every edge of a tour found elsewhere
+    void reinforceTour(const vector<int>& route, float length, float weight);
+
+    // Migration: pheromones = (1 - weight) * pheromones + weight * mean of the sources
+    void blendPheromones(const vector<const AlignedMatrix*>& sources, float weight);
+
+    // Migration: adds weight * amount to both directions of every edge (edge = i * n + j)
+    void applyPheromoneDeltas(const vector<EdgeDelta>& deltas, float weight);
+
+    // Ant scheduler of run(), for load-balance reporting (null before the first run)
+    const WorkStealingScheduler* getScheduler() const {
+        return scheduler.get();
+    }
+
     // Select the next city for the ant to visit based on probabilities
-    // To make Thread Safe: had to support an optional thread-local probablity row 
-    int selectNextCity(shared_ptr<Ant> ant, vector<float>* localProbRow = nullptr, float random01 = -1.0f);
+    // To make Thread Safe: pass a thread-local workspace and random value
+    // Without a workspace the GUI probability matrix is also updated
+    int selectNextCity(Ant& ant, ConstructionWorkspace* workspace = nullptr, float random01 = -1.0f);
     float evaporationRate = 0.5f;
     float Q = 500.0f; // Constant for pheromone deposit
+    DepositStrategy depositStrategy = DepositStrategy::Auto;
+    float minPheromone = 1e-6f; // Lower clamp, keeps every edge selectable and evaporation out of denormals
+    float maxPheromone = numeric_limits<float>::max(); // Upper clamp
 
 private: 
 
-    // Vectors representing matrices for pheromones, probabilities, and proximities
-    vector<vector<float>> pheromones;
-    vector<vector<float>> probablitys;
-    vector<vector<float>> proximitys;
+    // Flat, cache-line aligned matrices for pheromones, probabilities, and proximities
+    AlignedMatrix pheromones;
+    AlignedMatrix probablitys;
+    AlignedMatrix proximitys;
+    AlignedMatrix heuristics; // eta^beta, only changes when beta changes
+    AlignedMatrix choiceInfo; // tau^alpha * eta^beta, refreshed after every pheromone update
+    vector<int> nearestNeighbors; // nnListSize closest cities per city, row-major, nearest first
+    int nnListSize = 0;
+    ConstructionWorkspace sequentialWorkspace; // Used when no thread-local workspace is passed
+    vector<vector<EdgeDelta>> depositBuckets; // [producer thread * threads + owner thread], reused every iteration
+    vector<pair<size_t, size_t>> depositRows; // Per row [begin, end) into its owner's reduced deltas
+    int depositTeam = 1; // Threads that produced the pending deltas, also the bucket grid width
+    DepositStrategy activeDepositStrategy = DepositStrategy::Sequential; // Strategy of the current update
+    unique_ptr<WorkStealingScheduler> scheduler; // Ant scheduler of run()
+    BestTourRegister bestTours; // Tours are numbered iteration * ants + ant
+    uint64_t completedIterations = 0; // Iterations of earlier runs, so later runs draw fresh numbers
+    bool deterministic = false;
+    bool localSearch = false;
+    StartupTimings startupTimings;
+
+    // NUMA placement
+    vector<int> pinnedCpus;         // CPU of each team thread, empty when not pinned
+    vector<int> workerNode;         // Node of each pinned thread
+    vector<int> workerNodeRank;     // Position of each pinned thread among its node's threads
+    vector<int> nodeThreads;        // Pinned threads per node
+    bool numaReplicas = false;
+    vector<AlignedMatrix> choiceReplicas; // One choiceInfo copy per node, empty when unused
+
+    // Columns per tile of the fused update sweep (8 KB per matrix, so a tile of
+    // tau, eta and choice stays in L1)
+    static constexpr size_t fusedTileWidth = 2048;
+
+    // Choice matrices larger than this are written with streaming stores
+    static constexpr size_t streamingStoreThreshold = size_t(64) << 20;
     vector<shared_ptr<Ant>> ants;
     vector<shared_ptr<city>>& citys;
 
+    // runPipelined() double buffers: the choice snapshot its ants read while the updater
+    // writes choiceInfo, and the ant set being built while the updater reads ants
+    AlignedMatrix pipelineChoice;
+    vector<shared_ptr<Ant>> pipelineAnts;
+
     // Single value constants for the algorithm
     int maxIterations;
+    float alpha = 1.0f; // Importance of pheromone
+    float beta = 5.0f;  // Importance of heuristic information
+    int numThreads = 0; // Team size of run(), 0 for the OpenMP default
+    unique_ptr<ExecutionBackend> backend = makeExecutionBackend(BackendKind::OpenMP); // See setExecutionBackend
+    int updaterThreads = 0; // Update team of runPipelined(), 0 for a quarter of the team
+
+    // Per-instance random state: rng for the step-by-step GUI path, seed keys run()'s Philox draws
+    unsigned seed;
+    mt19937 rng;
+
+    // tau^alpha * eta^beta kernels, specialized when alpha/beta are small integers
+    const weights::WeightKernel* weightKernel;
     
+    // Constructor body: every initialization phase, timed
+    void initializeInstance(int candidateListSize);
+
     // Initialize parameters for the algorithm
     void initializeParameters();
+
+    // Resolve DepositStrategy::Auto
+    DepositStrategy chooseDepositStrategy() const;
+
+    // Add Q / routeLength to every edge of every ant's route
+    bool depositPheromones(float keep);
+
+    // Pieces of depositPheromones, also used one ant at a time by run()'s task graph
+    void prepareDeposit(int team, float keep, bool concurrent);
+    void depositAnt(const Ant& ant, int antIndex, int producer, float keep);
+    void reduceDeposits(int owner);
+
+    // Fused evaporation, pending deposit, clamp and choice-info refresh
+    void evaporateAndRefresh(float keep, bool pendingDeltas);
+
+    // The same sweep for rows [begin, end) only
+    void refreshRows(int begin, int end, float keep, bool pendingDeltas);
+
+    // First row owned by sort-reduce owner t (rows a with a * team / n == t)
+    int ownerRowBegin(int owner, int team) const {
+        const int64_t n = static_cast<int64_t>(citys.size());
+        return static_cast<int>((owner * n + team - 1) / team);
+    }
+
+    // Rows per sweep task of run()'s task graph
+    static constexpr int sweepTaskRows = 64;
+
+    // 2-opt passes over a tour before giving up, and candidates tried per city
+    static constexpr int localSearchPasses = 64;
+    static constexpr int localSearchNeighbours = 10;
+
+    // Candidate-list 2-opt on a finished tour, first improvement, until no move helps
+    void improveTour(Ant& ant, ConstructionWorkspace& workspace);
+
+    // Body of updatePheromones, run by every thread of the calling team
+    void updatePheromonesInTeam();
+
+    // updatePheromones with each phase (deposit, reduce, sweep) as one loop of the backend
+    void updatePheromonesOnBackend(ExecutionBackend& backend);
+
+    // Build the heuristics matrix (1/distance)^beta from the proximity matrix
+    void computeHeuristicInformation();
+
+    // Build the nearest neighbour candidate list of every city
+    void initializeCandidateLists(int listSize);
+
+    // Best unvisited city by choice information, used when every candidate is taken
+    int bestUnvisitedCity(const Ant& ant, ConstructionWorkspace& workspace, const float* choice);
+
+    // Rows at least this long (candidates, or cities for bestUnvisitedCity) are scanned in
+    // selectionChunk pieces, split over the ant's StepTeam when it has one
+    // A chunk is a quarter of the threshold, so every scanned row splits into at least four
+    int parallelSelectionThreshold = 16384;
+    int selectionChunk = 4096;
+    atomic<uint64_t> teamWeightScans{ 0 };
+    atomic<uint64_t> teamBestUnvisitedScans{ 0 };
+
+    // runAsynchronous() renormalizes a row once its lazy evaporation scale would pass 2^lazyScaleBits
+    static constexpr double lazyScaleBits = 20.0;
+
+    // One thread's share (chunks member, member + members, ...) of a long-row scan
+    void scanChunks(StepScan scan, const Ant& ant, const float* row, ConstructionWorkspace& workspace,
+                    int member, int members);
+
+    // Runs a long-row scan on the workspace's team (or alone) and returns once every chunk is done
+    void runStepScan(StepScan scan, const Ant& ant, const float* row, ConstructionWorkspace& workspace);
+
+    // Helper side of a StepTeam: scans whatever the leader posts until it posts Finish
+    void assistStepTeam(StepTeam& team, int member);
+
+    // Releases the helpers of the workspace's team after the leader's tour
+    void finishStepTeam(ConstructionWorkspace& workspace);
     
     // Display all pheromone trails (for debugging or information)
     void showAllPheromoneTrails();
@@ -111,15 +460,43 @@ private:
     // Check if the termination condition of the algorithm is met
     bool terminationCondition(int iteration);
     
-    // Update the probabilities for choosing the next city
-    // Updated: Takes an optional vector<float>* localProbRow
-    void updateProbablity(shared_ptr<Ant> ant, const vector<int>& feasibleCityIndexes, vector<float>* localProbRow = nullptr);
-    
-    // Construct solutions based on the current state of the ant and environment
-    void constructAntSolutions(shared_ptr<Ant>& ant);
+    // Record the probabilities of the ant's candidate moves in the GUI probability matrix
+    void updateProbablity(const Ant& ant, const float* weights, float total);
     
     // Update pheromones based on the ant's route
 
+    // Threads of the teams this instance starts
+    int teamSize() const {
+        return numThreads > 0 ? numThreads : omp_get_max_threads();
+    }
+
+    // Binds the calling team thread to its planned CPU until the returned guard is destroyed,
+    // which restores the thread's previous affinity (no-op when not pinned)
+    [[nodiscard]] numa::ScopedPin pinWorker(int worker) const {
+        return numa::ScopedPin(pinnedCpus.empty() ? -1 : pinnedCpus[worker % pinnedCpus.size()]);
+    }
+
+    // Allocates a matrix and writes it with the team's static row partition, so each row's
+    // pages sit on the node of the thread that later sweeps that row
+    void firstTouch(AlignedMatrix& matrix, size_t rows, size_t cols, float value);
+
+    // Moves an existing matrix's pages next to the (re)pinned team by copying it with that team
+    void rehome(AlignedMatrix& matrix);
+
+    // Allocates the per-node choice replicas for the current pinning (or drops them)
+    void prepareReplicas();
+
+    // Copies this thread's share of its node's replica from choiceInfo, then waits for the team
+    void refreshReplica(int worker);
+
+    // Fills out[0 .. count) with the draws of (iteration, ant): draw s is word s % 4 of the
+    // Philox block { s / 4, ant, iteration }, the same on every thread and SIMD level
+    void antUniforms(uint64_t iteration, int ant, float* out, size_t count) const;
+
+    // Builds ant antIndex's whole tour of the given iteration from counter-based draws
+    void constructTour(Ant& ant, uint64_t iteration, int antIndex, ConstructionWorkspace& workspace);
+
+
     // Get a random city index
     int getRandomCityIndex(int numberOfCities) {
         uniform_int_distribution<int> dist(0, numberOfCities - 1);
@@ -0,0 +1,122 @@
+#ifndef ALIGNED_MATRIX_H
+#define ALIGNED_MATRIX_H
+
+#include <cstddef>
+#include <new>
+#include <span>
+#include <utility>
+#include <algorithm>
+
+// Dense row-major float matrix stored in a single 64-byte aligned block
+// Every row is padded to a whole number of cache lines so rows never share a line
+// Padding cells are kept at zero, so whole-buffer sweeps (evaporation) are safe
+class AlignedMatrix {
+public:
+    static constexpr std::size_t alignment = 64;
+    static constexpr std::size_t floatsPerLine = alignment / sizeof(float);
+
+    AlignedMatrix() = default;
+
+    // Allocates a rows x cols matrix with every cell set to value
+    AlignedMatrix(std::size_t rows, std::size_t cols, float value = 0.0f) {
+        resize(rows, cols, value);
+    }
+
+    ~AlignedMatrix() {
+        release();
+    }
+
+    AlignedMatrix(const AlignedMatrix&) = delete;
+    AlignedMatrix& operator=(const AlignedMatrix&) = delete;
+
+    AlignedMatrix(AlignedMatrix&& other) noexcept {
+        swap(other);
+    }
+
+    AlignedMatrix& operator=(AlignedMatrix&& other) noexcept {
+        if (this != &other) {
+            release();
+            swap(other);
+        }
+        return *this;
+    }
+
+    // Reallocates the matrix; previous contents are discarded
+    void resize(std::size_t rows, std::size_t cols, float value = 0.0f) {
+        allocate(rows, cols);
+        std::fill(cells, cells + paddedSize(), 0.0f);
+        fill(value);
+    }
+
+    // Reallocates without writing any cell, so each page lands on the NUMA node of the
+    // thread that first writes it; every cell, padding included, must be written before use
+    void allocate(std::size_t rows, std::size_t cols) {
+        release();
+        numRows = rows;
+        numCols = cols;
+        rowStride = (cols + floatsPerLine - 1) / floatsPerLine * floatsPerLine;
+        if (numRows * rowStride > 0) {
+            cells = static_cast<float*>(::operator new(numRows * rowStride * sizeof(float),
+                                                       std::align_val_t(alignment)));
+        }
+    }
+
+    // Copies shape and contents of other, reusing this allocation when the shape already matches
+    void copyFrom(const AlignedMatrix& other) {
+        if (numRows != other.numRows || numCols != other.numCols) {
+            allocate(other.numRows, other.numCols);
+        }
+        std::copy(other.cells, other.cells + other.paddedSize(), cells);
+    }
+
+    // Sets every logical cell to value, padding stays zero
+    void fill(float value) {
+        for (std::size_t i = 0; i < numRows; ++i) {
+            std::fill(row(i), row(i) + numCols, value);
+        }
+    }
+
+    // Number of rows, named like vector<vector<float>>::size() so row loops keep working
+    std::size_t size() const { return numRows; }
+    std::size_t rows() const { return numRows; }
+    std::size_t cols() const { return numCols; }
+
+    // Distance in floats between the starts of consecutive rows
+    std::size_t stride() const { return rowStride; }
+
+    // Total number of floats including row padding
+    std::size_t paddedSize() const { return numRows * rowStride; }
+
+    float* data() { return cells; }
+    const float* data() const { return cells; }
+
+    float* row(std::size_t i) { return cells + i * rowStride; }
+    const float* row(std::size_t i) const { return cells + i * rowStride; }
+
+    // Row views so matrix[i][j] and matrix[i].size() read like the old nested vectors
+    std::span<float> operator[](std::size_t i) { return { row(i), numCols }; }
+    std::span<const float> operator[](std::size_t i) const { return { row(i), numCols }; }
+
+private:
+    float* cells = nullptr;
+    std::size_t numRows = 0;
+    std::size_t numCols = 0;
+    std::size_t rowStride = 0;
+
+    void release() {
+        if (cells) {
+            ::operator delete(cells, std::align_val_t(alignment));
+            cells = nullptr;
+        }
+        numRows = numCols = rowStride = 0;
+    }
+
+    void swap(AlignedMatrix& other) noexcept {
+        std::swap(cells, other.cells);
+        std::swap(numRows, other.numRows);
+        std::swap(numCols, other.numCols);
+        std::swap(rowStride, other.rowStride);
+    }
+};
+
+#endif // ALIGNED_MATRIX_H
@@ -1,6 +1,3 @@
-#define ENABLE_PARALLEL 1
-#define PARALLEL_PHEROMONES 1
-
 #ifndef ANT_H
 #define ANT_H
 
@@ -16,11 +13,19 @@
 #include <cstddef>
 #include <ctime>
 #include <filesystem>
+#include <cstdint>
 
 #include "raylib.h"
 
-#if ENABLE_PARALLEL
+// How a run is parallelized is picked at run time (see ExecutionBackend.h); a build without
+// OpenMP still compiles, with every OpenMP team reduced to the calling thread
+#ifdef _OPENMP
 #include <omp.h>
+#else
+// Stand-ins so thread-aware code also builds without OpenMP
+inline int omp_get_thread_num() { return 0; }
+inline int omp_get_num_threads() { return 1; }
+inline int omp_get_max_threads() { return 1; }
 #endif
 
 
@@ -29,65 +34,98 @@ using namespace std;
 // Structure to represent a city in the simulation
 struct city {
     int id; // Unique identifier for the city
-    bool visited; // Flag to check if the city has been visited by an ant
+    bool visited; // Legacy flag, ants track their own visits in Ant::visitedBits
     Vector2 position; // Position of the city in a 2D space
 
     // Constructor to initialize a city with an ID, visited status, and position
     city(int cityId, bool visitedIn, Vector2 positionIn) : id(cityId), visited(visitedIn), position(positionIn) {}
 };
 
+// Compact list of city indices making up a route
+// Stored as uint16_t while the instance has fewer than 65536 cities, uint32_t otherwise
+class CityRoute {
+public:
+    explicit CityRoute(size_t numCities = 0) : wide(numCities > 65535) {}
+
+    void reserve(size_t n){
+      if (wide) wideIds.reserve(n); else narrowIds.reserve(n);
+    }
+
+    void push_back(int cityIdx){
+      if (wide) wideIds.push_back(static_cast<uint32_t>(cityIdx));
+      else narrowIds.push_back(static_cast<uint16_t>(cityIdx));
+    }
+
+    int operator[](size_t i) const {
+      return wide ? static_cast<int>(wideIds[i]) : static_cast<int>(narrowIds[i]);
+    }
+
+    int front() const { return (*this)[0]; }
+    int back() const { return (*this)[size() - 1]; }
+    size_t size() const { return wide ? wideIds.size() : narrowIds.size(); }
+    bool empty() const { return size() == 0; }
+
+    void clear(){
+      narrowIds.clear();
+      wideIds.clear();
+    }
+
+private:
+    bool wide;
+    vector<uint16_t> narrowIds;
+    vector<uint32_t> wideIds;
+};
+
 // Class to represent an ant in the simulation
 class Ant {
 public:
 
     // Constructor to initialize an ant with a unique ID and default route length
-    Ant(int antId) : routeLength(0), id(antId) {}
+    // numCities sizes the ant's visited bitset and picks the route's index width
+    Ant(int antId, size_t numCities)
+      : visitedBits((numCities + 63) / 64, 0), route(numCities), routeLength(0), id(antId) {
+      route.reserve(numCities + 1);
+    }
 
-    // Visits a specified city
+    // Places the ant on its starting city
     // Marks the city as visited, updates the current city, and appends it to the route
-    void visitCity(shared_ptr<city> c){
-      currCity = c;
-      currCity->visited = true;
-      route.push_back(currCity);
+    void visitCity(int cityIdx){
+      currCity = cityIdx;
+      markVisited(cityIdx);
+      route.push_back(cityIdx);
     }
 
-    // Visits the current city
-    // Marks the current city as visited and appends it to the route
-    void visitCity(){
-      routeLength += sqrt(pow((currCity->position.x - route.back()->position.x),2) + 
-                          pow((currCity->position.y - route.back()->position.y),2));
-      cout << routeLength << endl;
-      route.push_back(currCity);
-      
+    // Moves the ant from its current city to cityIdx
+    // edgeLength is the distance travelled, which is added to the route length
+    void visitCity(int cityIdx, float edgeLength){
+      routeLength += edgeLength;
+      visitCity(cityIdx);
     }
 
     // Checks if a city has been visited by the ant
-    // Returns true if the city with the specified ID is found in the route
-    bool hasVisited(int cityId){
-      for(const auto& visitedCity : route){
-        if(visitedCity->id == cityId)
-          return true;
-      }
-      return false;
+    // Single bit test in the ant's own bitset, so concurrent ants never share state
+    bool hasVisited(int cityId) const {
+      return (visitedBits[cityId >> 6] >> (cityId & 63)) & 1u;
     }
 
     // Resets all of the ant's values
-    // Clears the route and sets all visited flags to false
+    // Clears the route and the visited bitset (one word per 64 cities)
     void reset(){
       route.clear();
+      fill(visitedBits.begin(), visitedBits.end(), 0);
       routeLength = 0.0f;
     }
 
-    void clearCitys(){
-      for(auto& city : route)
-        city->visited = false;
-
+    // Sets the visited bit of a city
+    void markVisited(int cityId){
+      visitedBits[cityId >> 6] |= uint64_t(1) << (cityId & 63);
     }
 
-    vector<shared_ptr<city>> route; // Vector to store the route taken by the ant
+    vector<uint64_t> visitedBits; // Bit j is set once city j has been visited
+    CityRoute route; // City indices of the route taken by the ant
     Vector2 position; // Current position of the ant in 2D space
-    int routeLength; // Length of the route taken by the ant
-    shared_ptr<city> currCity; // Pointer to the current city being visited by the ant
+    float routeLength; // Length of the route taken by the ant
+    int currCity = -1; // Index of the city the ant is currently at
     int id; // Unique identifier for the ant
 };
 
@@ -9,8 +9,8 @@
         DrawText(currIteration.c_str(), 10, 30, 20, DARKGRAY);
         
         string antsRoute = "Current Ant Route: [";
-        for (auto city : ant->route) {
-            string cityText = to_string(city->id);
+        for (size_t k = 0; k < ant->route.size(); ++k) {
+            string cityText = to_string(ant->route[k]);
             antsRoute += cityText + ", ";
         }
         antsRoute += "]";
@@ -20,7 +20,7 @@
     // Set the current ant for rendering
     void AntGraphics::setAnt(shared_ptr<Ant> newAnt) {
         currAnt = newAnt;
-        currCity = newAnt->currCity;
+        currCity = cities[newAnt->currCity];
     }
     
     // Get current position of the ant
@@ -39,7 +39,7 @@
 	if(delta > 1.0f/20.0f)
 		delta = 1.0f/20.f;
 
-        currCity = currAnt->currCity;
+        currCity = cities[currAnt->currCity];
         moveToNextPoint(delta);
     }
 
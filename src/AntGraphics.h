@@ -2,6 +2,7 @@
 #define ANTGRAPHICS_H
 
 #include "Ant.h"
+#include "AlignedMatrix.h"
 
 // Constants
 #define WIDTH 2000
@@ -19,8 +20,8 @@ struct Point {
 class AntGraphics {
 	public:
 		// Constructor that initializes the graphical representation of the ants			
-         AntGraphics(vector<shared_ptr<Ant>>& antRefs, vector<vector<float>>& pheromonesIn, vector<vector<float>>& proximitysIn,
-                vector<vector<float>>& probablitysIn, vector<shared_ptr<city>> citiesIn, float simSpeed, int totalIterations)
+         AntGraphics(vector<shared_ptr<Ant>>& antRefs, AlignedMatrix& pheromonesIn, AlignedMatrix& proximitysIn,
+                AlignedMatrix& probablitysIn, vector<shared_ptr<city>> citiesIn, float simSpeed, int totalIterations)
         : ants(antRefs),
           pheromones(pheromonesIn),
           proximitys(proximitysIn),
@@ -72,9 +73,9 @@ class AntGraphics {
         shared_ptr<Ant> currAnt;
         shared_ptr<city> currCity;
         vector<shared_ptr<Ant>>& ants;  
-        vector<vector<float>>& pheromones;
-        vector<vector<float>>& proximitys;
-        vector<vector<float>>& probablitys;
+        AlignedMatrix& pheromones;
+        AlignedMatrix& proximitys;
+        AlignedMatrix& probablitys;
         vector<shared_ptr<city>> cities;
         Texture2D antTexture;
         int iterations;
@@ -0,0 +1,68 @@
+#include "BestTour.h"
+
+BestTourRegister::~BestTourRegister() {
+    clear();
+}
+
+/*
+ * Installs candidate as the new head
+ * - Re-checks against every head it sees: if another thread published something at
+ *   least as good in the meantime, the candidate is dropped instead of retried
+ * - The release half of the exchange publishes the candidate's route along with the pointer
+ */
+bool BestTourRegister::publish(PublishedTour* candidate) {
+    const PublishedTour* expected = head.load(memory_order_acquire);
+    do {
+        if (!beats(candidate->length, candidate->tour, expected)) {
+            delete candidate;
+            return false;
+        }
+        candidate->previous = expected;
+    } while (!head.compare_exchange_weak(expected, candidate, memory_order_acq_rel, memory_order_acquire));
+
+    published.fetch_add(1, memory_order_relaxed);
+    return true;
+}
+
+void BestTourRegister::freeChain(const PublishedTour* tour) {
+    while (tour) {
+        const PublishedTour* previous = tour->previous;
+        delete tour;
+        tour = previous;
+    }
+}
+
+/*
+ * Cuts the retired chain off the head and frees it
+ * - Only offers link tours to the head, so with none running the head's chain is the owner's
+ * - A guard taken before the readers check may still hold a retired tour, so then the chain
+ *   is parked on detached; a guard taken after it can only load the head, which stays
+ */
+void BestTourRegister::reclaim() {
+    const PublishedTour* best = head.load(memory_order_acquire);
+    if (best && best->previous) {
+        const PublishedTour* retired = best->previous;
+        const_cast<PublishedTour*>(best)->previous = nullptr;
+
+        const PublishedTour* last = retired;
+        while (last->previous) {
+            last = last->previous;
+        }
+        const_cast<PublishedTour*>(last)->previous = detached;
+        detached = retired;
+    }
+    if (detached && readers.load(memory_order_seq_cst) == 0) {
+        freeChain(detached);
+        detached = nullptr;
+    }
+}
+
+/*
+ * Walks the retired chain from the head and frees every tour
+ */
+void BestTourRegister::clear() {
+    freeChain(head.exchange(nullptr, memory_order_acquire));
+    freeChain(detached);
+    detached = nullptr;
+    published.store(0, memory_order_relaxed);
+}
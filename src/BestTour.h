@@ -0,0 +1,104 @@
+#ifndef BEST_TOUR_H
+#define BEST_TOUR_H
+
+#include <vector>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+using namespace std;
+
+// One published tour; never changed once other threads can see it
+struct PublishedTour {
+    float length;
+    uint64_t tour;                  // Tour number, breaks ties between equal lengths (lower wins)
+    vector<int> route;              // City order, start city repeated at the end
+    const PublishedTour* previous;  // The tour this one replaced
+};
+
+// Best-so-far tour shared by every thread of a solver
+// Writers race with a compare-and-swap on the head pointer, comparing lengths before each
+// attempt; a tour that does not beat the head is rejected after one atomic load, so the
+// common case neither allocates nor writes shared memory. Replaced tours are retired onto
+// the previous chain rather than freed, so a pointer a reader got from current() stays valid
+// until the owner's next reclaim(): reading is a single acquire load, wait-free and lock-free
+// The owner reclaims at quiescent points (between iterations, when none of its own threads
+// holds a pointer); another thread that keeps a pointer across iterations holds a ReadGuard
+class BestTourRegister {
+public:
+    // While any guard is alive, reclaim() keeps the retired tours and frees them later
+    class ReadGuard {
+    public:
+        explicit ReadGuard(const BestTourRegister& tours) : owner(tours) {
+            owner.readers.fetch_add(1, memory_order_seq_cst);
+        }
+        ~ReadGuard() {
+            owner.readers.fetch_sub(1, memory_order_seq_cst);
+        }
+
+        ReadGuard(const ReadGuard&) = delete;
+        ReadGuard& operator=(const ReadGuard&) = delete;
+
+    private:
+        const BestTourRegister& owner;
+    };
+
+    BestTourRegister() = default;
+    ~BestTourRegister();
+
+    BestTourRegister(const BestTourRegister&) = delete;
+    BestTourRegister& operator=(const BestTourRegister&) = delete;
+
+    // Publishes a tour if it beats the current best; returns true if it did
+    // route can be anything indexable with a size(), e.g. vector<int> or CityRoute
+    template <typename Route>
+    bool offer(float length, uint64_t tour, const Route& route) {
+        if (!improves(length, tour)) {
+            return false;
+        }
+        PublishedTour* candidate = new PublishedTour{ length, tour, vector<int>(route.size()), nullptr };
+        for (size_t k = 0; k < route.size(); ++k) {
+            candidate->route[k] = route[k];
+        }
+        return publish(candidate);
+    }
+
+    // True when (length, tour) would replace the current best
+    bool improves(float length, uint64_t tour) const {
+        return beats(length, tour, current());
+    }
+
+    // Current best, null before the first publication
+    const PublishedTour* current() const {
+        return head.load(memory_order_acquire);
+    }
+
+    // Successful publications since the last clear()
+    uint64_t publications() const {
+        return published.load(memory_order_relaxed);
+    }
+
+    // Frees the tours the head has replaced, keeping the head; no offer may run meanwhile
+    // If a ReadGuard is held they are kept until a later call finds none
+    void reclaim();
+
+    // Frees the current and every retired tour; no other thread may use the register meanwhile
+    void clear();
+
+private:
+    atomic<const PublishedTour*> head{ nullptr };
+    atomic<uint64_t> published{ 0 };
+    mutable atomic<int> readers{ 0 };
+    const PublishedTour* detached = nullptr; // Retired tours cut off the head while a guard was held
+
+    static void freeChain(const PublishedTour* tour);
+
+    static bool beats(float length, uint64_t tour, const PublishedTour* best) {
+        return !best || length < best->length || (length == best->length && tour < best->tour);
+    }
+
+    // CAS loop that installs candidate, or deletes it once a better tour is already in place
+    bool publish(PublishedTour* candidate);
+};
+
+#endif // BEST_TOUR_H
@@ -0,0 +1,458 @@
+#include "DistributedRunner.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+// Little helpers to pack plain values into message payloads (host byte order)
+namespace {
+    template <class T>
+    void put(vector<uint8_t>& out, T value) {
+        size_t at = out.size();
+        out.resize(at + sizeof(T));
+        std::memcpy(out.data() + at, &value, sizeof(T));
+    }
+
+    template <class T>
+    bool get(const vector<uint8_t>& in, size_t& at, T& value) {
+        if (in.size() - at < sizeof(T)) {
+            return false;
+        }
+        std::memcpy(&value, in.data() + at, sizeof(T));
+        at += sizeof(T);
+        return true;
+    }
+
+    // Each process searches with its own random streams
+    IslandConfig seededForRank(IslandConfig colonies, int rank) {
+        colonies.seed += 104729u * static_cast<unsigned>(rank);
+        return colonies;
+    }
+
+    // Layout of a PheromoneDelta payload after its header
+    enum class DeltaFormat : uint8_t {
+        Sparse = 0, // (edge, int16) pairs
+        Dense = 1   // int16 per upper-triangle edge
+    };
+
+    // Deposit estimates at most this fraction of the current value are float rounding of the
+    // evaporation estimate, not deposits
+    constexpr float depositNoise = 1e-4f;
+
+    // Min-heap order on |amount|, so the heap front is the smallest change kept so far
+    bool largerChange(const EdgeDelta& a, const EdgeDelta& b) {
+        return std::fabs(a.amount) > std::fabs(b.amount);
+    }
+}
+
+DistributedRunner::DistributedRunner(vector<shared_ptr<city>>& cities, Transport& inTransport,
+                                     const DistributedConfig& inConfig)
+    : citys(cities),
+    transport(inTransport),
+    config(inConfig),
+    model(cities, seededForRank(inConfig.colonies, inTransport.rank())),
+    sharedBest(numeric_limits<float>::max()),
+    globalBest(numeric_limits<float>::max()),
+    reported(inTransport.size(), false) {
+    lastExchange.copyFrom(model.getIsland(0).getPheromones());
+}
+
+/*
+ * Iterates in epochs of exchangeInterval iterations
+ * - After each epoch: send own best tour and pheromone delta, apply what peers sent,
+ *   then remember the gateway pheromones so the next delta holds only new local changes
+ * - Stops early when the coordinator says so, then reports
+ */
+void DistributedRunner::run() {
+    const int interval = config.exchangeInterval > 0 ? config.exchangeInterval : config.iterations;
+
+    iterating = true;
+    while (counters.iterationsRun < config.iterations && !stopRequested) {
+        int epoch = std::min(interval, config.iterations - counters.iterationsRun);
+        model.run(epoch);
+        counters.iterationsRun += epoch;
+        ++counters.exchanges;
+
+        offerTour(model.getGlobalBestRoute(), model.getGlobalBest(), false);
+        shareBestTour();
+        sharePheromoneDelta(epoch);
+        drainMessages();
+        lastExchange.copyFrom(model.getIsland(0).getPheromones());
+    }
+    iterating = false;
+    counters.stoppedEarly = counters.iterationsRun < config.iterations;
+
+    if (transport.rank() == 0) {
+        finishAsCoordinator();
+    }
+    else {
+        finishAsWorker();
+    }
+}
+
+Message DistributedRunner::tourMessage(MessageType type, const vector<int>& route, float length) const {
+    const bool wide = citys.size() > 65535;
+    Message message;
+    message.type = type;
+    put(message.payload, length);
+    put(message.payload, static_cast<uint32_t>(route.size()));
+    for (int c : route) {
+        if (wide) {
+            put(message.payload, static_cast<uint32_t>(c));
+        }
+        else {
+            put(message.payload, static_cast<uint16_t>(c));
+        }
+    }
+    return message;
+}
+
+bool DistributedRunner::decodeTour(const Message& message, vector<int>& route, float& length) const {
+    const bool wide = citys.size() > 65535;
+    size_t at = 0;
+    uint32_t count = 0;
+    if (!get(message.payload, at, length) || !get(message.payload, at, count) || count > citys.size() + 1) {
+        return false;
+    }
+    route.resize(count);
+    for (uint32_t k = 0; k < count; ++k) {
+        uint32_t c = 0;
+        if (wide) {
+            if (!get(message.payload, at, c)) return false;
+        }
+        else {
+            uint16_t narrow = 0;
+            if (!get(message.payload, at, narrow)) return false;
+            c = narrow;
+        }
+        if (c >= citys.size()) {
+            return false;
+        }
+        route[k] = static_cast<int>(c);
+    }
+    return true;
+}
+
+void DistributedRunner::shareBestTour() {
+    const float best = model.getGlobalBest();
+    if (best < sharedBest && !model.getGlobalBestRoute().empty()) {
+        transport.broadcast(tourMessage(MessageType::BestTour, model.getGlobalBestRoute(), best));
+        sharedBest = best;
+        ++counters.toursSent;
+    }
+}
+
+/*
+ * Sends the deposits the gateway colony made since the last exchange
+ * - Every peer evaporates its own matrix, so only the deposit component is sent: the change
+ *   against lastExchange evaporated for the epoch's iterations (clamped at minPheromone, which
+ *   is what the per-iteration clamp gives); sending the raw change would evaporate twice
+ * - Only the upper triangle is scanned (the matrix is symmetric)
+ * - The maxDeltaEntries largest deposits are kept with a bounded min-heap
+ * - Values are quantized to int16 against the largest kept |change|
+ * - Sent sparse, as (edge, value) pairs, unless a dense int16 upper triangle would not be larger
+ *   (when most edges changed, a sparse entry's 6 bytes lose to the dense form's 2 per edge)
+ * Payload: cities (uint32), format (uint8), scale (float), then
+ * - Sparse: count (uint32), then count x (edge, int16), with edge = i * n + j as uint32,
+ *   or uint64 past 65535 cities
+ * - Dense: n * (n - 1) / 2 int16, the upper triangle row by row, zero for edges not kept
+ */
+void DistributedRunner::sharePheromoneDelta(int iterations) {
+    if (transport.size() < 2 || config.maxDeltaEntries <= 0) {
+        return;
+    }
+
+    ACO& gateway = model.getIsland(0);
+    const AlignedMatrix& current = gateway.getPheromones();
+    const size_t n = citys.size();
+    const size_t limit = static_cast<size_t>(config.maxDeltaEntries);
+    const float floor = gateway.getMinPheromone();
+    float decay = 1.0f;
+    for (int k = 0; k < iterations; ++k) {
+        decay *= 1.0f - config.colonies.evaporationRate;
+    }
+
+    vector<EdgeDelta> kept;
+    kept.reserve(limit);
+    for (size_t i = 0; i < n; ++i) {
+        const float* now = current.row(i);
+        const float* before = lastExchange.row(i);
+        for (size_t j = i + 1; j < n; ++j) {
+            float change = now[j] - std::max(before[j] * decay, floor);
+            if (change <= depositNoise * now[j]) {
+                continue;
+            }
+            if (kept.size() < limit) {
+                kept.push_back({ i * n + j, change });
+                std::push_heap(kept.begin(), kept.end(), largerChange);
+            }
+            else if (std::fabs(change) > std::fabs(kept.front().amount)) {
+                std::pop_heap(kept.begin(), kept.end(), largerChange);
+                kept.back() = { i * n + j, change };
+                std::push_heap(kept.begin(), kept.end(), largerChange);
+            }
+        }
+    }
+    if (kept.empty()) {
+        return;
+    }
+
+    float largest = 0.0f;
+    for (const EdgeDelta& d : kept) {
+        largest = std::max(largest, std::fabs(d.amount));
+    }
+    const float scale = largest / 32767.0f;
+    const bool wide = n > 65535;
+    const size_t pairs = n * (n - 1) / 2;
+    const size_t sparseBytes = sizeof(uint32_t) + kept.size() * ((wide ? sizeof(uint64_t) : sizeof(uint32_t)) + sizeof(int16_t));
+    const bool dense = pairs * sizeof(int16_t) <= sparseBytes;
+
+    Message message;
+    message.type = MessageType::PheromoneDelta;
+    put(message.payload, static_cast<uint32_t>(n));
+    put(message.payload, static_cast<uint8_t>(dense ? DeltaFormat::Dense : DeltaFormat::Sparse));
+    put(message.payload, scale);
+    if (dense) {
+        vector<int16_t> triangle(pairs, 0);
+        for (const EdgeDelta& d : kept) {
+            const size_t i = d.edge / n, j = d.edge % n;
+            triangle[i * n - i * (i + 1) / 2 + (j - i - 1)] = static_cast<int16_t>(std::lround(d.amount / scale));
+        }
+        const size_t at = message.payload.size();
+        message.payload.resize(at + pairs * sizeof(int16_t));
+        std::memcpy(message.payload.data() + at, triangle.data(), pairs * sizeof(int16_t));
+    }
+    else {
+        put(message.payload, static_cast<uint32_t>(kept.size()));
+        for (const EdgeDelta& d : kept) {
+            if (wide) {
+                put(message.payload, d.edge);
+            }
+            else {
+                put(message.payload, static_cast<uint32_t>(d.edge));
+            }
+            put(message.payload, static_cast<int16_t>(std::lround(d.amount / scale)));
+        }
+    }
+
+    transport.broadcast(message);
+    ++counters.deltasSent;
+    counters.deltaBytes += message.payload.size();
+    counters.denseDeltaBytes += pairs * sizeof(float);
+}
+
+void DistributedRunner::drainMessages() {
+    Message message;
+    while (transport.poll(message, 0)) {
+        handle(message);
+    }
+}
+
+/*
+ * Records a tour if it beats the best known here
+ * - Peer tours (reinforce = true) are also deposited into every local colony
+ */
+void DistributedRunner::offerTour(const vector<int>& route, float length, bool reinforce) {
+    if (route.empty() || !(length < globalBest)) {
+        return;
+    }
+    globalBest = length;
+    globalBestRoute = route;
+
+    if (reinforce) {
+        for (int i = 0; i < model.islandCount(); ++i) {
+            model.getIsland(i).reinforceTour(route, length, config.tourWeight);
+        }
+        ++counters.toursApplied;
+    }
+}
+
+void DistributedRunner::handle(const Message& message) {
+    switch (message.type) {
+    case MessageType::BestTour: {
+        vector<int> route;
+        float length;
+        if (decodeTour(message, route, length)) {
+            offerTour(route, length, iterating);
+        }
+        break;
+    }
+    case MessageType::PheromoneDelta: {
+        if (!iterating) {
+            break;
+        }
+        size_t at = 0;
+        uint32_t n = 0;
+        uint8_t format = 0;
+        float scale = 0.0f;
+        if (!get(message.payload, at, n) || !get(message.payload, at, format) || !get(message.payload, at, scale)
+            || n != citys.size() || !std::isfinite(scale) || scale < 0.0f) {
+            break;
+        }
+        // Anything malformed drops the whole delta; nothing is applied from a partial decode
+        const uint64_t pairs = static_cast<uint64_t>(n) * (n - 1) / 2;
+        const size_t remaining = message.payload.size() - at;
+        vector<EdgeDelta> deltas;
+        if (format == static_cast<uint8_t>(DeltaFormat::Dense)) {
+            if (remaining != pairs * sizeof(int16_t)) {
+                break;
+            }
+            for (uint64_t i = 0; i < n; ++i) {
+                for (uint64_t j = i + 1; j < n; ++j) {
+                    int16_t quantized = 0;
+                    if (!get(message.payload, at, quantized)) {
+                        return;
+                    }
+                    if (quantized != 0) {
+                        deltas.push_back({ i * n + j, quantized * scale });
+                    }
+                }
+            }
+        }
+        else if (format == static_cast<uint8_t>(DeltaFormat::Sparse)) {
+            uint32_t count = 0;
+            const bool wide = n > 65535;
+            const size_t entryBytes = (wide ? sizeof(uint64_t) : sizeof(uint32_t)) + sizeof(int16_t);
+            if (!get(message.payload, at, count) || count > pairs
+                || message.payload.size() - at != count * entryBytes) {
+                break;
+            }
+            deltas.resize(count);
+            for (uint32_t k = 0; k < count; ++k) {
+                uint64_t edge = 0;
+                int16_t quantized = 0;
+                bool read = true;
+                if (wide) {
+                    read = get(message.payload, at, edge);
+                }
+                else {
+                    uint32_t narrow = 0;
+                    read = get(message.payload, at, narrow);
+                    edge = narrow;
+                }
+                // Upper-triangle edges only, as sharePheromoneDelta writes them
+                if (!read || !get(message.payload, at, quantized) || edge >= uint64_t(n) * n || edge / n >= edge % n) {
+                    return;
+                }
+                deltas[k] = { edge, quantized * scale };
+            }
+        }
+        else {
+            break;
+        }
+        model.getIsland(0).applyPheromoneDeltas(deltas, config.deltaWeight);
+        ++counters.deltasApplied;
+        break;
+    }
+    case MessageType::Done: {
+        vector<int> route;
+        float length;
+        if (transport.rank() == 0 && message.from > 0 && message.from < transport.size()
+            && decodeTour(message, route, length)) {
+            reported[message.from] = true;
+            offerTour(route, length, false);
+        }
+        break;
+    }
+    case MessageType::Stop:
+        stopRequested = true;
+        break;
+    case MessageType::GlobalBest: {
+        vector<int> route;
+        float length;
+        if (decodeTour(message, route, length)) {
+            globalBest = length;
+            globalBestRoute = route;
+            finalReceived = true;
+        }
+        break;
+    }
+    }
+}
+
+/*
+ * Coordinator shutdown
+ * - Waits for every rank's Done; after stragglerGraceSeconds it sends Stop, so slow ranks
+ *   cut their run short, and after resultTimeoutSeconds more it gives up on the missing ones
+ * - Broadcasts the best tour over every result received
+ */
+void DistributedRunner::finishAsCoordinator() {
+    using clock_type = chrono::steady_clock;
+    const auto finished = clock_type::now();
+    reported[0] = true;
+
+    bool stopSent = false;
+    while (true) {
+        // One bounded wait, then whatever else is queued; a chatty straggler must not keep
+        // this loop from reaching the grace-period check
+        Message message;
+        if (transport.poll(message, 20)) {
+            handle(message);
+            drainMessages();
+        }
+
+        int waiting = 0;
+        for (int r = 1; r < transport.size(); ++r) {
+            if (!reported[r] && transport.connected(r)) {
+                ++waiting;
+            }
+        }
+        if (waiting == 0) {
+            break;
+        }
+
+        double elapsed = chrono::duration<double>(clock_type::now() - finished).count();
+        if (!stopSent && elapsed > config.stragglerGraceSeconds) {
+            transport.broadcast(Message{ MessageType::Stop, 0, {} });
+            stopSent = true;
+        }
+        if (elapsed > config.stragglerGraceSeconds + config.resultTimeoutSeconds) {
+            break;
+        }
+    }
+
+    for (int r = 1; r < transport.size(); ++r) {
+        if (!reported[r]) {
+            ++counters.missingResults;
+        }
+    }
+
+    if (!globalBestRoute.empty()) {
+        transport.broadcast(tourMessage(MessageType::GlobalBest, globalBestRoute, globalBest));
+    }
+}
+
+/*
+ * Worker shutdown: report to the coordinator, then wait for the global best
+ * - Gives up if the coordinator disconnects; globalBest then holds the best seen here
+ */
+void DistributedRunner::finishAsWorker() {
+    transport.send(0, tourMessage(MessageType::Done, model.getGlobalBestRoute(), model.getGlobalBest()));
+
+    while (!finalReceived && transport.connected(0)) {
+        Message message;
+        if (transport.poll(message, 20)) {
+            handle(message);
+        }
+    }
+}
+
+void DistributedRunner::printReport(ostream& out) const {
+    out << "Distributed rank " << transport.rank() << "/" << transport.size() << ": "
+        << counters.iterationsRun << " iterations" << (counters.stoppedEarly ? " (stopped by coordinator)" : "")
+        << ", " << counters.exchanges << " exchanges\n";
+    out << "  local best " << getLocalBest() << ", global best " << globalBest << "\n";
+    out << "  tours sent " << counters.toursSent << ", applied " << counters.toursApplied
+        << "; deltas sent " << counters.deltasSent << ", applied " << counters.deltasApplied << "\n";
+    if (counters.denseDeltaBytes > 0) {
+        out << "  delta payload " << counters.deltaBytes << " bytes, "
+            << 100.0 * static_cast<double>(counters.deltaBytes) / static_cast<double>(counters.denseDeltaBytes)
+            << "% of the " << counters.denseDeltaBytes << " bytes of dense float triangles\n";
+    }
+    const TransportStats& traffic = transport.stats();
+    out << "  transport: " << traffic.messagesSent << " sent, " << traffic.messagesReceived << " received, "
+        << traffic.messagesDropped << " dropped, " << traffic.bytesSent << " bytes out\n";
+    if (transport.rank() == 0 && counters.missingResults > 0) {
+        out << "  " << counters.missingResults << " ranks never reported\n";
+    }
+}
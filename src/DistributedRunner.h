@@ -0,0 +1,86 @@
+#ifndef DISTRIBUTED_RUNNER_H
+#define DISTRIBUTED_RUNNER_H
+
+#include "IslandModel.h"
+#include "Transport.h"
+
+using namespace std;
+
+// Settings of one process of a distributed solve; every process should use the same values
+struct DistributedConfig {
+    IslandConfig colonies;              // Colonies hosted by this process; seeds are offset by rank
+    int iterations = 100;               // Iterations per process
+    int exchangeInterval = 10;          // Iterations between exchanges with peers
+    int maxDeltaEntries = 4096;         // Largest pheromone changes sent per exchange
+    float deltaWeight = 0.5f;           // Share of a peer's pheromone change applied here
+    float tourWeight = 0.1f;            // Deposit weight of an incoming tour better than ours
+    double stragglerGraceSeconds = 2.0; // How long the coordinator waits for slow peers before Stop
+    double resultTimeoutSeconds = 10.0; // How long it then waits for their results
+};
+
+// Exchange counters of one process
+struct DistributedStats {
+    int exchanges = 0;
+    int iterationsRun = 0;
+    int toursSent = 0;
+    int toursApplied = 0;          // Incoming tours that beat the best known here
+    int deltasSent = 0;
+    int deltasApplied = 0;
+    uint64_t deltaBytes = 0;       // Payload bytes of the deltas sent (sparse or dense int16, whichever is smaller)
+    uint64_t denseDeltaBytes = 0;  // What the same deltas would take as dense float upper triangles
+    bool stoppedEarly = false;     // Stop arrived before this process finished its iterations
+    int missingResults = 0;        // Coordinator only: peers whose result never arrived
+};
+
+// One process of a multi-process solve
+// Hosts an IslandModel and, every exchangeInterval iterations, sends its best tour and the
+// largest changes of its gateway colony's (island 0) pheromones to every peer, then applies
+// whatever peers have sent. Nothing waits on a peer while iterating, so a slow process only
+// delivers its messages later. Rank 0 also coordinates: it collects every process's best,
+// sends Stop to stragglers after a grace period, and broadcasts the global best
+class DistributedRunner {
+public:
+    DistributedRunner(vector<shared_ptr<city>>& cities, Transport& transport, const DistributedConfig& config);
+
+    void run();
+
+    IslandModel& getModel() { return model; }
+    const DistributedStats& stats() const { return counters; }
+
+    float getLocalBest() const { return model.getGlobalBest(); }
+
+    // Best over every process (the coordinator's answer once run() has returned)
+    float getGlobalBest() const { return globalBest; }
+    const vector<int>& getGlobalBestRoute() const { return globalBestRoute; }
+
+    void printReport(ostream& out) const;
+
+private:
+    vector<shared_ptr<city>>& citys;
+    Transport& transport;
+    DistributedConfig config;
+    IslandModel model;
+    DistributedStats counters;
+
+    AlignedMatrix lastExchange;    // Gateway pheromones right after the previous exchange
+    float sharedBest;              // Best length already sent to peers
+    float globalBest;
+    vector<int> globalBestRoute;
+    bool iterating = false;        // Peer tours are only deposited while colonies still run
+    bool stopRequested = false;
+    bool finalReceived = false;
+    vector<bool> reported;         // Coordinator: ranks whose Done has arrived
+
+    void shareBestTour();
+    void sharePheromoneDelta(int iterations);
+    void drainMessages();
+    void handle(const Message& message);
+    void offerTour(const vector<int>& route, float length, bool reinforce);
+    void finishAsCoordinator();
+    void finishAsWorker();
+
+    Message tourMessage(MessageType type, const vector<int>& route, float length) const;
+    bool decodeTour(const Message& message, vector<int>& route, float& length) const;
+};
+
+#endif // DISTRIBUTED_RUNNER_H
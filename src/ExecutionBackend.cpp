@@ -0,0 +1,264 @@
+// libstdc++ sends par / par_unseq to TBB whenever the TBB headers are installed, and the binary
+// then has to link -ltbb; builds that do not opt in with EXECUTION_BACKEND_TBB get its serial
+// backend instead, so the program links the same everywhere (MSVC is unaffected)
+#if !defined(EXECUTION_BACKEND_TBB) && !defined(_GLIBCXX_USE_TBB_PAR_BACKEND)
+#define _GLIBCXX_USE_TBB_PAR_BACKEND 0
+#endif
+
+#include "ExecutionBackend.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <numeric>
+#include <thread>
+#include <version>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#if defined(__cpp_lib_execution) && __cpp_lib_execution >= 201902L
+#include <execution>
+#define BACKEND_HAS_EXECUTION 1
+#else
+#define BACKEND_HAS_EXECUTION 0
+#endif
+
+// True when par / par_unseq actually run on more than the calling thread
+#if BACKEND_HAS_EXECUTION && !defined(_PSTL_PAR_BACKEND_SERIAL)
+static constexpr bool parallelAlgorithmsThreaded = true;
+#else
+static constexpr bool parallelAlgorithmsThreaded = false;
+#endif
+
+// The OpenMP default (OMP_NUM_THREADS) when no count is given, like the solver's own teams
+static int defaultThreads() {
+#ifdef _OPENMP
+    return omp_get_max_threads();
+#else
+    return static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+#endif
+}
+
+static int resolveThreads(int threads) {
+    return threads > 0 ? threads : defaultThreads();
+}
+
+/*
+ * Sequential backend: the reference every other backend has to match
+ */
+class SequentialBackend : public ExecutionBackend {
+public:
+    BackendKind kind() const override { return BackendKind::Sequential; }
+    int concurrency() const override { return 1; }
+
+    void forEach(int count, const function<void(int)>& body) override {
+        for (int i = 0; i < count; ++i) {
+            body(i);
+        }
+    }
+};
+
+/*
+ * OpenMP backend: one parallel for per loop; the runtime keeps its threads between loops
+ * - Without a thread count every loop takes the current OpenMP default
+ */
+class OpenMPBackend : public ExecutionBackend {
+public:
+    explicit OpenMPBackend(int threads) : threads(threads) {}
+
+    BackendKind kind() const override { return BackendKind::OpenMP; }
+    int concurrency() const override { return resolveThreads(threads); }
+
+    void forEach(int count, const function<void(int)>& body) override {
+#pragma omp parallel for schedule(dynamic) num_threads(concurrency())
+        for (int i = 0; i < count; ++i) {
+            body(i);
+        }
+    }
+
+private:
+    int threads; // 0 for the OpenMP default
+};
+
+/*
+ * Native thread pool: threads - 1 persistent workers plus the calling thread
+ * - A loop is published under the lock with a new generation number; everyone then claims
+ *   chunks of indices from a shared atomic counter until the range is exhausted
+ * - The caller returns once every worker has left the loop, so body and its captures
+ *   never outlive the call
+ * - Not reentrant: a body must not start another loop on the same pool
+ */
+class ThreadPoolBackend : public ExecutionBackend {
+public:
+    explicit ThreadPoolBackend(int threads) {
+        const int total = resolveThreads(threads);
+        for (int t = 1; t < total; ++t) {
+            workers.emplace_back([this] { workerLoop(); });
+        }
+    }
+
+    ~ThreadPoolBackend() override {
+        {
+            lock_guard<mutex> guard(lock);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+
+    BackendKind kind() const override { return BackendKind::ThreadPool; }
+    int concurrency() const override { return static_cast<int>(workers.size()) + 1; }
+
+    void forEach(int count, const function<void(int)>& body) override {
+        if (count <= 0) {
+            return;
+        }
+        if (workers.empty() || count == 1) {
+            for (int i = 0; i < count; ++i) {
+                body(i);
+            }
+            return;
+        }
+
+        {
+            lock_guard<mutex> guard(lock);
+            job = &body;
+            jobCount = count;
+            grain = std::max(1, count / (8 * concurrency()));
+            next.store(0, memory_order_relaxed);
+            busy = static_cast<int>(workers.size());
+            ++generation;
+        }
+        wake.notify_all();
+
+        drain();
+
+        unique_lock<mutex> guard(lock);
+        finished.wait(guard, [this] { return busy == 0; });
+        job = nullptr;
+    }
+
+private:
+    vector<thread> workers;
+    mutex lock;
+    condition_variable wake;      // A new loop (or shutdown) is posted
+    condition_variable finished;  // The last worker left the loop
+    uint64_t generation = 0;
+    bool stopping = false;
+
+    // Current loop, written under the lock before the generation changes
+    const function<void(int)>* job = nullptr;
+    int jobCount = 0;
+    int grain = 1;
+    atomic<int> next{ 0 };
+    int busy = 0; // Workers that have not finished the current loop
+
+    void drain() {
+        for (int begin; (begin = next.fetch_add(grain, memory_order_relaxed)) < jobCount; ) {
+            const int end = std::min(begin + grain, jobCount);
+            for (int i = begin; i < end; ++i) {
+                (*job)(i);
+            }
+        }
+    }
+
+    void workerLoop() {
+        uint64_t seen = 0;
+        for (;;) {
+            {
+                unique_lock<mutex> guard(lock);
+                wake.wait(guard, [&] { return stopping || generation != seen; });
+                if (stopping) {
+                    return;
+                }
+                seen = generation;
+            }
+
+            drain();
+
+            lock_guard<mutex> guard(lock);
+            if (--busy == 0) {
+                finished.notify_one();
+            }
+        }
+    }
+};
+
+/*
+ * C++17 parallel algorithms: std::for_each over an index vector
+ * - forEach uses par, forEachUnsequenced par_unseq; the thread count is up to the library
+ *   (the MSVC runtime's pool, or TBB for libstdc++ built with EXECUTION_BACKEND_TBB)
+ * - Falls back to a plain loop when the standard library has no execution policies; it then
+ *   reports a concurrency of 1, as it does when libstdc++ runs the policies serially
+ */
+class ParallelAlgorithmsBackend : public ExecutionBackend {
+public:
+    explicit ParallelAlgorithmsBackend(int threads) : threads(parallelAlgorithmsThreaded ? resolveThreads(threads) : 1) {}
+
+    BackendKind kind() const override { return BackendKind::ParallelAlgorithms; }
+    int concurrency() const override { return threads; }
+
+    void forEach(int count, const function<void(int)>& body) override {
+        prepareIndices(count);
+#if BACKEND_HAS_EXECUTION
+        std::for_each(std::execution::par, indices.begin(), indices.begin() + count, [&](int i) { body(i); });
+#else
+        std::for_each(indices.begin(), indices.begin() + count, [&](int i) { body(i); });
+#endif
+    }
+
+    void forEachUnsequenced(int count, const function<void(int)>& body) override {
+        prepareIndices(count);
+#if BACKEND_HAS_EXECUTION
+        std::for_each(std::execution::par_unseq, indices.begin(), indices.begin() + count, [&](int i) { body(i); });
+#else
+        std::for_each(indices.begin(), indices.begin() + count, [&](int i) { body(i); });
+#endif
+    }
+
+private:
+    int threads;
+    vector<int> indices; // 0, 1, 2, ...; grown as needed and kept between loops
+
+    void prepareIndices(int count) {
+        const int have = static_cast<int>(indices.size());
+        if (count > have) {
+            indices.resize(count);
+            std::iota(indices.begin() + have, indices.end(), have);
+        }
+    }
+};
+
+unique_ptr<ExecutionBackend> makeExecutionBackend(BackendKind kind, int threads) {
+    switch (kind) {
+    case BackendKind::OpenMP: return make_unique<OpenMPBackend>(threads);
+    case BackendKind::ThreadPool: return make_unique<ThreadPoolBackend>(threads);
+    case BackendKind::ParallelAlgorithms: return make_unique<ParallelAlgorithmsBackend>(threads);
+    default: return make_unique<SequentialBackend>();
+    }
+}
+
+const char* backendName(BackendKind kind) {
+    switch (kind) {
+    case BackendKind::OpenMP: return "openmp";
+    case BackendKind::ThreadPool: return "threadpool";
+    case BackendKind::ParallelAlgorithms: return "stdpar";
+    default: return "sequential";
+    }
+}
+
+bool parseBackendKind(const char* name, BackendKind& kind) {
+    for (BackendKind candidate : { BackendKind::Sequential, BackendKind::OpenMP, BackendKind::ThreadPool,
+                                   BackendKind::ParallelAlgorithms }) {
+        if (std::strcmp(name, backendName(candidate)) == 0) {
+            kind = candidate;
+            return true;
+        }
+    }
+    return false;
+}
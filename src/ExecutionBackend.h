@@ -0,0 +1,51 @@
+#ifndef EXECUTION_BACKEND_H
+#define EXECUTION_BACKEND_H
+
+#include <vector>
+#include <memory>
+#include <functional>
+
+using namespace std;
+
+// Ways of running a parallel loop, selectable at run time
+enum class BackendKind {
+    Sequential,         // Plain loop on the calling thread
+    OpenMP,             // omp parallel for, dynamic schedule
+    ThreadPool,         // Persistent std::thread workers sharing an atomic index
+    ParallelAlgorithms  // std::for_each with std::execution::par / par_unseq
+};
+
+// Executes index loops for a solver; one instance can be reused for any number of loops
+// Bodies must be independent of each other. forEach bodies may use atomics and allocate;
+// forEachUnsequenced bodies must be vectorization-safe (no locks, atomics or allocation),
+// which lets the parallel-algorithms backend run them under par_unseq
+class ExecutionBackend {
+public:
+    virtual ~ExecutionBackend() = default;
+
+    virtual BackendKind kind() const = 0;
+
+    // Threads a loop is spread over (1 for Sequential; the library's choice for ParallelAlgorithms
+    // is not known, so that backend reports the thread count it was created with, or 1 when
+    // the standard library runs the policies serially)
+    virtual int concurrency() const = 0;
+
+    // Runs body(i) for every i in [0, count) and returns once all have finished
+    virtual void forEach(int count, const function<void(int)>& body) = 0;
+
+    // Same, for vectorization-safe bodies
+    virtual void forEachUnsequenced(int count, const function<void(int)>& body) {
+        forEach(count, body);
+    }
+};
+
+// threads <= 0 means the OpenMP default (OMP_NUM_THREADS), or the hardware concurrency
+// in a build without OpenMP
+unique_ptr<ExecutionBackend> makeExecutionBackend(BackendKind kind, int threads = 0);
+
+const char* backendName(BackendKind kind);
+
+// Parses "sequential", "openmp", "threadpool" or "stdpar"; returns false for anything else
+bool parseBackendKind(const char* name, BackendKind& kind);
+
+#endif // EXECUTION_BACKEND_H
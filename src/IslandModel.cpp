@@ -0,0 +1,184 @@
+#include "IslandModel.h"
+
+#include <barrier>
+#include <set>
+#include <thread>
+
+IslandModel::IslandModel(vector<shared_ptr<city>>& cities, const IslandConfig& inConfig)
+    : config(inConfig) {
+    const int count = std::max(config.islands, 1);
+    threadsPerIsland = config.threadsPerIsland > 0
+        ? config.threadsPerIsland
+        : std::max(omp_get_max_threads() / count, 1);
+
+    // One plan over every island's threads, sliced per island; only when the slices are disjoint
+    islandCpus.assign(count, {});
+    vector<int> plan = numa::pinningPlan(config.pinning, count * threadsPerIsland);
+    if (!plan.empty() && set<int>(plan.begin(), plan.end()).size() == plan.size()) {
+        for (int i = 0; i < count; ++i) {
+            islandCpus[i].assign(plan.begin() + i * threadsPerIsland, plan.begin() + (i + 1) * threadsPerIsland);
+        }
+    }
+
+    islands.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        auto island = make_unique<ACO>(cities, config.antsPerIsland, config.Q,
+                                       config.evaporationRate, config.candidateListSize);
+        island->setAlpha(config.alpha);
+        island->setBeta(config.beta);
+        island->setSeed(config.seed + 7919u * static_cast<unsigned>(i));
+        island->setThreadCount(threadsPerIsland);
+        if (!islandCpus[i].empty()) {
+            island->setThreadPinning(islandCpus[i]);
+        }
+        islands.push_back(std::move(island));
+    }
+
+    publishedRoutes.resize(count);
+    publishedLengths.assign(count, numeric_limits<float>::max());
+    publishedImproved.assign(count, 0);
+    publishedPheromones.resize(count);
+}
+
+/*
+ * Runs all islands side by side, one driver thread each
+ * - Every island runs migrationInterval iterations on its own OpenMP team, pinned to its own
+ *   CPU slice, and the driver stays on the slice's first CPU between epochs
+ * - At a migration point all islands publish, wait, read their sources, and wait
+ *   again so no island publishes the next epoch while another is still reading
+ * - No migration after the last epoch
+ */
+void IslandModel::run(int iterations) {
+    const int count = islandCount();
+    const int interval = config.migrationInterval > 0 ? config.migrationInterval : iterations;
+    const int epochs = interval > 0 ? (iterations + interval - 1) / interval : 0;
+
+    std::barrier migrationPoint(count);
+
+    vector<std::thread> drivers;
+    drivers.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        drivers.emplace_back([&, i]() {
+            const numa::ScopedPin pin(islandCpus[i].empty() ? -1 : islandCpus[i].front());
+            ACO& island = *islands[i];
+            for (int epoch = 0; epoch < epochs; ++epoch) {
+                island.setMaxIterations(std::min(interval, iterations - epoch * interval));
+                island.run();
+
+                if (epoch + 1 == epochs || count == 1) {
+                    continue;
+                }
+                publish(i);
+                migrationPoint.arrive_and_wait();
+                immigrate(i);
+                migrationPoint.arrive_and_wait();
+            }
+        });
+    }
+    for (auto& driver : drivers) {
+        driver.join();
+    }
+
+    if (count > 1 && epochs > 1) {
+        migrations += epochs - 1;
+    }
+}
+
+vector<int> IslandModel::migrationSources(int i) const {
+    const int count = islandCount();
+    vector<int> sources;
+    if (config.topology == MigrationTopology::Ring) {
+        sources.push_back((i + count - 1) % count);
+    }
+    else {
+        for (int j = 0; j < count; ++j) {
+            if (j != i) {
+                sources.push_back(j);
+            }
+        }
+    }
+    return sources;
+}
+
+void IslandModel::publish(int i) {
+    const ACO& island = *islands[i];
+    if (config.policy == MigrationPolicy::BestTour) {
+        // An island that found nothing new keeps its old slot and sends no migrant this time,
+        // so its receivers do not reinforce the same tour every epoch
+        publishedImproved[i] = island.getBestLength() < publishedLengths[i];
+        if (publishedImproved[i]) {
+            publishedRoutes[i] = island.getBestRoute();
+            publishedLengths[i] = island.getBestLength();
+        }
+    }
+    else {
+        publishedPheromones[i].copyFrom(islands[i]->getPheromones());
+    }
+}
+
+/*
+ * Receives migrants from the topology's sources
+ * - BestTour: deposits the shortest tour among the sources that improved since the last exchange
+ * - PheromoneBlend: mixes in the average of the sources' published matrices
+ */
+void IslandModel::immigrate(int i) {
+    const vector<int> sources = migrationSources(i);
+    ACO& island = *islands[i];
+
+    if (config.policy == MigrationPolicy::BestTour) {
+        int best = -1;
+        for (int j : sources) {
+            if (publishedImproved[j] && (best < 0 || publishedLengths[j] < publishedLengths[best])) {
+                best = j;
+            }
+        }
+        if (best >= 0) {
+            island.reinforceTour(publishedRoutes[best], publishedLengths[best], config.migrationWeight);
+            migrantTours.fetch_add(1);
+        }
+    }
+    else {
+        vector<const AlignedMatrix*> matrices;
+        for (int j : sources) {
+            matrices.push_back(&publishedPheromones[j]);
+        }
+        island.blendPheromones(matrices, config.migrationWeight);
+    }
+}
+
+int IslandModel::getGlobalBestIsland() const {
+    int best = 0;
+    for (int i = 1; i < islandCount(); ++i) {
+        if (islands[i]->getBestLength() < islands[best]->getBestLength()) {
+            best = i;
+        }
+    }
+    return best;
+}
+
+float IslandModel::getGlobalBest() const {
+    return islands[getGlobalBestIsland()]->getBestLength();
+}
+
+const vector<int>& IslandModel::getGlobalBestRoute() const {
+    return islands[getGlobalBestIsland()]->getBestRoute();
+}
+
+void IslandModel::printReport(ostream& out) const {
+    out << "Island model: " << islandCount() << " islands x " << threadsPerIsland << " threads, "
+        << (config.topology == MigrationTopology::Ring ? "ring" : "fully connected") << " topology, "
+        << (config.policy == MigrationPolicy::BestTour ? "best-tour" : "pheromone-blend") << " migration every "
+        << config.migrationInterval << " iterations (" << migrations << " migrations";
+    if (config.policy == MigrationPolicy::BestTour) {
+        out << ", " << migrantTours.load() << " migrant tours";
+    }
+    out << ")\n";
+    for (int i = 0; i < islandCount(); ++i) {
+        out << "  island " << i << ": best " << islands[i]->getBestLength();
+        for (size_t c = 0; c < islandCpus[i].size(); ++c) {
+            out << (c == 0 ? ", cpus " : ",") << islandCpus[i][c];
+        }
+        out << "\n";
+    }
+    out << "  global best: " << getGlobalBest() << " (island " << getGlobalBestIsland() << ")\n";
+}
@@ -0,0 +1,98 @@
+#ifndef ISLAND_MODEL_H
+#define ISLAND_MODEL_H
+
+#include "ACO.h"
+
+#include <atomic>
+#include <ostream>
+
+using namespace std;
+
+// Which colonies an island receives migrants from
+enum class MigrationTopology {
+    Ring,           // Island i receives from island i - 1
+    FullyConnected  // Every island receives from every other island
+};
+
+// What migrates between colonies
+enum class MigrationPolicy {
+    BestTour,       // The best incoming tour is deposited into the receiver's pheromones
+    PheromoneBlend  // The receiver's pheromones are mixed with the average of the incoming matrices
+};
+
+// Settings of a multi-colony run
+struct IslandConfig {
+    int islands = 4;
+    int antsPerIsland = 20;
+    float Q = 100.0f;
+    float evaporationRate = 0.5f;
+    float alpha = 1.0f;
+    float beta = 5.0f;
+    int candidateListSize = 20;
+    int migrationInterval = 10;   // Iterations between migrations (k)
+    MigrationTopology topology = MigrationTopology::Ring;
+    MigrationPolicy policy = MigrationPolicy::BestTour;
+    float migrationWeight = 0.1f; // Tour deposit weight, or blend weight in [0, 1]
+    unsigned seed = 12345;        // Island i is seeded with seed + 7919 * i
+    int threadsPerIsland = 0;     // 0 splits the OpenMP default evenly over the islands
+    // Island i's team gets CPUs [i * threadsPerIsland, (i + 1) * threadsPerIsland) of one plan
+    // over the whole machine; skipped when the islands' threads outnumber the CPUs
+    numa::PinningPolicy pinning = numa::PinningPolicy::Compact;
+};
+
+// Island-model ACO: independent colonies, each with its own pheromone matrix, ants
+// and thread team, exchanging information every migrationInterval iterations
+// Colonies only meet at migrations, so throughput grows with the number of islands
+// instead of being capped by one colony's ant count and update phase
+class IslandModel {
+public:
+    IslandModel(vector<shared_ptr<city>>& cities, const IslandConfig& config);
+
+    // Runs every island for the given number of iterations, migrating in between
+    void run(int iterations);
+
+    int islandCount() const { return static_cast<int>(islands.size()); }
+    ACO& getIsland(int i) { return *islands[i]; }
+    int getThreadsPerIsland() const { return threadsPerIsland; }
+    int getMigrations() const { return migrations; }
+    // Tours actually deposited by BestTour migrations (sources that had not improved send none)
+    int getMigrantTours() const { return migrantTours.load(); }
+    // CPUs of island i's team, empty when the islands run unpinned
+    const vector<int>& getIslandCpus(int i) const { return islandCpus[i]; }
+
+    float getIslandBest(int i) const { return islands[i]->getBestLength(); }
+
+    // Best tour over all islands and the island that found it
+    float getGlobalBest() const;
+    int getGlobalBestIsland() const;
+    const vector<int>& getGlobalBestRoute() const;
+
+    // Per-island and global best tour lengths
+    void printReport(ostream& out) const;
+
+private:
+    IslandConfig config;
+    vector<unique_ptr<ACO>> islands;
+    int threadsPerIsland = 1;
+    int migrations = 0;
+    atomic<int> migrantTours{ 0 };
+    vector<vector<int>> islandCpus;
+
+    // What every island published at the last migration point
+    vector<vector<int>> publishedRoutes;
+    vector<float> publishedLengths;
+    vector<char> publishedImproved; // The published tour is shorter than the one of the previous exchange
+    vector<AlignedMatrix> publishedPheromones;
+
+    // Islands that island i receives migrants from
+    vector<int> migrationSources(int i) const;
+
+    // Copies island i's best tour (only if it improved since the last exchange) or its
+    // pheromones into its published slot
+    void publish(int i);
+
+    // Applies the published state of island i's sources to island i
+    void immigrate(int i);
+};
+
+#endif // ISLAND_MODEL_H
@@ -0,0 +1,529 @@
+#include "Kernels.h"
+#include "Philox.h"
+
+#include <atomic>
+#include <bit>
+#include <cstring>
+#include <cmath>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define KERNELS_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#else
+#define KERNELS_X86 0
+#endif
+
+// GCC and Clang need the target ISA per function, MSVC accepts intrinsics anywhere
+#if KERNELS_X86 && (defined(__GNUC__) || defined(__clang__))
+#define KERNELS_TARGET(isa) __attribute__((target(isa)))
+#else
+#define KERNELS_TARGET(isa)
+#endif
+
+namespace kernels {
+
+    /*
+     * Scalar reference kernels
+     */
+    static float gatherWeightsScalar(const float* row, const int* indexes, const uint64_t* visitedBits,
+                                     int count, float* weights, int* feasible) {
+        float total = 0.0f;
+        int open = 0;
+        for (int k = 0; k < count; ++k) {
+            int j = indexes[k];
+            bool visited = (visitedBits[j >> 6] >> (j & 63)) & 1u;
+            weights[k] = visited ? 0.0f : row[j];
+            total += weights[k];
+            open += !visited;
+        }
+        *feasible = open;
+        return total;
+    }
+
+    static int rouletteSearchScalar(const float* weights, int count, float target) {
+        float cumulative = 0.0f;
+        for (int k = 0; k < count; ++k) {
+            if (weights[k] > 0.0f) {
+                cumulative += weights[k];
+                if (cumulative >= target) {
+                    return k;
+                }
+            }
+        }
+        return -1;
+    }
+
+    static void scaleScalar(float* data, size_t count, float factor) {
+        for (size_t i = 0; i < count; ++i) {
+            data[i] *= factor;
+        }
+    }
+
+    // Philox blocks one at a time starting at block firstBlock; also finishes the vector versions' tails
+    static void philoxUniformsFrom(const uint32_t* key, const uint32_t* tail, size_t firstBlock, float* out, size_t count) {
+        for (size_t s = 0; s < count; s += 4) {
+            philox::Counter bits = philox::generate({ static_cast<uint32_t>(firstBlock + s / 4), tail[0], tail[1], tail[2] },
+                                                    { key[0], key[1] });
+            for (size_t w = 0; w < 4 && s + w < count; ++w) {
+                out[s + w] = philox::toUniform(bits[w]);
+            }
+        }
+    }
+
+    static void philoxUniformsScalar(const uint32_t* key, const uint32_t* tail, float* out, size_t count) {
+        philoxUniformsFrom(key, tail, 0, out, count);
+    }
+
+    // Levels agree to the last bit or two: a compiler may fuse dx * dx + dy * dy into an FMA
+    static void distanceRowScalar(float x, float y, const float* xs, const float* ys, float* out, size_t count) {
+        for (size_t k = 0; k < count; ++k) {
+            float dx = xs[k] - x;
+            float dy = ys[k] - y;
+            out[k] = std::sqrt(dx * dx + dy * dy);
+        }
+    }
+
+#if KERNELS_X86
+    /*
+     * AVX2 kernels, 8 lanes
+     * - Visited bits are gathered as 32-bit words, which alias the 64-bit words on little endian
+     */
+    KERNELS_TARGET("avx2")
+    static float gatherWeightsAVX2(const float* row, const int* indexes, const uint64_t* visitedBits,
+                                   int count, float* weights, int* feasible) {
+        const int* words = reinterpret_cast<const int*>(visitedBits);
+        const __m256i low5 = _mm256_set1_epi32(31);
+        const __m256i one = _mm256_set1_epi32(1);
+        __m256 sum = _mm256_setzero_ps();
+        int open = 0;
+        int k = 0;
+
+        for (; k + 8 <= count; k += 8) {
+            __m256i idx = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(indexes + k));
+            __m256i word = _mm256_i32gather_epi32(words, _mm256_srli_epi32(idx, 5), 4);
+            __m256i bit = _mm256_and_si256(_mm256_srlv_epi32(word, _mm256_and_si256(idx, low5)), one);
+            __m256 unvisited = _mm256_castsi256_ps(_mm256_cmpeq_epi32(bit, _mm256_setzero_si256()));
+
+            __m256 w = _mm256_and_ps(_mm256_i32gather_ps(row, idx, 4), unvisited);
+            _mm256_storeu_ps(weights + k, w);
+            sum = _mm256_add_ps(sum, w);
+            open += std::popcount(static_cast<unsigned>(_mm256_movemask_ps(unvisited)));
+        }
+
+        __m128 half = _mm_add_ps(_mm256_castps256_ps128(sum), _mm256_extractf128_ps(sum, 1));
+        half = _mm_add_ps(half, _mm_movehl_ps(half, half));
+        half = _mm_add_ss(half, _mm_shuffle_ps(half, half, 1));
+        float total = _mm_cvtss_f32(half);
+
+        int tailOpen = 0;
+        total += gatherWeightsScalar(row, indexes + k, visitedBits, count - k, weights + k, &tailOpen);
+        *feasible = open + tailOpen;
+        return total;
+    }
+
+    KERNELS_TARGET("avx2")
+    static int rouletteSearchAVX2(const float* weights, int count, float target) {
+        const __m256 goal = _mm256_set1_ps(target);
+        const __m256 zero = _mm256_setzero_ps();
+        __m256 offset = zero;
+        int k = 0;
+
+        for (; k + 8 <= count; k += 8) {
+            __m256 w = _mm256_loadu_ps(weights + k);
+
+            // Inclusive prefix sum within each 128-bit half, then carry the low half into the high half
+            __m256 t = _mm256_add_ps(w, _mm256_castsi256_ps(_mm256_slli_si256(_mm256_castps_si256(w), 4)));
+            t = _mm256_add_ps(t, _mm256_castsi256_ps(_mm256_slli_si256(_mm256_castps_si256(t), 8)));
+            __m256 lastOfHalf = _mm256_permute_ps(t, _MM_SHUFFLE(3, 3, 3, 3));
+            t = _mm256_add_ps(t, _mm256_permute2f128_ps(lastOfHalf, lastOfHalf, 0x08));
+            t = _mm256_add_ps(t, offset);
+
+            __m256 hit = _mm256_and_ps(_mm256_cmp_ps(t, goal, _CMP_GE_OQ), _mm256_cmp_ps(w, zero, _CMP_GT_OQ));
+            int mask = _mm256_movemask_ps(hit);
+            if (mask) {
+                return k + std::countr_zero(static_cast<unsigned>(mask));
+            }
+
+            __m256 last = _mm256_permute_ps(t, _MM_SHUFFLE(3, 3, 3, 3));
+            offset = _mm256_permute2f128_ps(last, last, 0x11);
+        }
+
+        float cumulative = _mm256_cvtss_f32(offset);
+        for (; k < count; ++k) {
+            if (weights[k] > 0.0f) {
+                cumulative += weights[k];
+                if (cumulative >= target) {
+                    return k;
+                }
+            }
+        }
+        return -1;
+    }
+
+    KERNELS_TARGET("avx2")
+    static void scaleAVX2(float* data, size_t count, float factor) {
+        const __m256 f = _mm256_set1_ps(factor);
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8) {
+            _mm256_storeu_ps(data + i, _mm256_mul_ps(_mm256_loadu_ps(data + i), f));
+        }
+        scaleScalar(data + i, count - i, factor);
+    }
+
+    KERNELS_TARGET("avx2")
+    static void distanceRowAVX2(float x, float y, const float* xs, const float* ys, float* out, size_t count) {
+        const __m256 vx = _mm256_set1_ps(x);
+        const __m256 vy = _mm256_set1_ps(y);
+        size_t k = 0;
+        for (; k + 8 <= count; k += 8) {
+            __m256 dx = _mm256_sub_ps(_mm256_loadu_ps(xs + k), vx);
+            __m256 dy = _mm256_sub_ps(_mm256_loadu_ps(ys + k), vy);
+            __m256 squared = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+            _mm256_storeu_ps(out + k, _mm256_sqrt_ps(squared));
+        }
+        distanceRowScalar(x, y, xs + k, ys + k, out + k, count - k);
+    }
+
+    // Per-lane 32 x 32 -> 64 bit product split into high and low words
+    KERNELS_TARGET("avx2")
+    static inline void mulhiloAVX2(__m256i a, __m256i multiplier, __m256i& hi, __m256i& lo) {
+        __m256i even = _mm256_mul_epu32(a, multiplier);
+        __m256i odd = _mm256_mul_epu32(_mm256_srli_epi64(a, 32), multiplier);
+        lo = _mm256_blend_epi32(even, _mm256_slli_epi64(odd, 32), 0xAA);
+        hi = _mm256_blend_epi32(_mm256_srli_epi64(even, 32), odd, 0xAA);
+    }
+
+    KERNELS_TARGET("avx2")
+    static inline __m256 uniformsAVX2(__m256i bits) {
+        return _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(bits, 8)), _mm256_set1_ps(1.0f / 16777216.0f));
+    }
+
+    /*
+     * Eight Philox blocks per pass, one per lane, then a 4 x 8 transpose so the output is
+     * in block order like the scalar version
+     */
+    KERNELS_TARGET("avx2")
+    static void philoxUniformsAVX2(const uint32_t* key, const uint32_t* tail, float* out, size_t count) {
+        const __m256i m0 = _mm256_set1_epi32(static_cast<int>(philox::multiplier0));
+        const __m256i m1 = _mm256_set1_epi32(static_cast<int>(philox::multiplier1));
+        const __m256i laneBlocks = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+
+        size_t s = 0;
+        for (; s + 32 <= count; s += 32) {
+            __m256i x0 = _mm256_add_epi32(_mm256_set1_epi32(static_cast<int>(s / 4)), laneBlocks);
+            __m256i x1 = _mm256_set1_epi32(static_cast<int>(tail[0]));
+            __m256i x2 = _mm256_set1_epi32(static_cast<int>(tail[1]));
+            __m256i x3 = _mm256_set1_epi32(static_cast<int>(tail[2]));
+            uint32_t k0 = key[0], k1 = key[1];
+
+            for (int round = 0; round < 10; ++round) {
+                __m256i hi0, lo0, hi1, lo1;
+                mulhiloAVX2(x0, m0, hi0, lo0);
+                mulhiloAVX2(x2, m1, hi1, lo1);
+                x0 = _mm256_xor_si256(_mm256_xor_si256(hi1, x1), _mm256_set1_epi32(static_cast<int>(k0)));
+                x1 = lo1;
+                x2 = _mm256_xor_si256(_mm256_xor_si256(hi0, x3), _mm256_set1_epi32(static_cast<int>(k1)));
+                x3 = lo0;
+                k0 += philox::weyl0;
+                k1 += philox::weyl1;
+            }
+
+            // Within each 128-bit half: rows (words) to columns (blocks)
+            __m256i t0 = _mm256_unpacklo_epi32(x0, x1);
+            __m256i t1 = _mm256_unpacklo_epi32(x2, x3);
+            __m256i t2 = _mm256_unpackhi_epi32(x0, x1);
+            __m256i t3 = _mm256_unpackhi_epi32(x2, x3);
+            __m256i r0 = _mm256_unpacklo_epi64(t0, t1); // blocks 0 | 4
+            __m256i r1 = _mm256_unpackhi_epi64(t0, t1); // blocks 1 | 5
+            __m256i r2 = _mm256_unpacklo_epi64(t2, t3); // blocks 2 | 6
+            __m256i r3 = _mm256_unpackhi_epi64(t2, t3); // blocks 3 | 7
+
+            _mm256_storeu_ps(out + s, uniformsAVX2(_mm256_permute2x128_si256(r0, r1, 0x20)));
+            _mm256_storeu_ps(out + s + 8, uniformsAVX2(_mm256_permute2x128_si256(r2, r3, 0x20)));
+            _mm256_storeu_ps(out + s + 16, uniformsAVX2(_mm256_permute2x128_si256(r0, r1, 0x31)));
+            _mm256_storeu_ps(out + s + 24, uniformsAVX2(_mm256_permute2x128_si256(r2, r3, 0x31)));
+        }
+
+        philoxUniformsFrom(key, tail, s / 4, out + s, count - s);
+    }
+
+    /*
+     * AVX-512 kernels, 16 lanes
+     *
+     * GCC 12's avx512fintrin.h builds the pass-through operand of the unmasked intrinsics from
+     * _mm512_undefined_epi32(), a deliberate self-initialisation, and once those are inlined into
+     * mulhiloAVX512 and its callers -O2 reports it as -Wmaybe-uninitialized. That is a known header
+     * false positive (the lanes are never read), so it is silenced for this block only
+     */
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#endif
+    KERNELS_TARGET("avx512f")
+    static float gatherWeightsAVX512(const float* row, const int* indexes, const uint64_t* visitedBits,
+                                     int count, float* weights, int* feasible) {
+        const int* words = reinterpret_cast<const int*>(visitedBits);
+        const __m512i low5 = _mm512_set1_epi32(31);
+        const __m512i one = _mm512_set1_epi32(1);
+        __m512 sum = _mm512_setzero_ps();
+        int open = 0;
+        int k = 0;
+
+        for (; k + 16 <= count; k += 16) {
+            __m512i idx = _mm512_loadu_si512(indexes + k);
+            __m512i word = _mm512_i32gather_epi32(_mm512_srli_epi32(idx, 5), words, 4);
+            __mmask16 unvisited = _mm512_testn_epi32_mask(
+                _mm512_srlv_epi32(word, _mm512_and_si512(idx, low5)), one);
+
+            __m512 w = _mm512_mask_i32gather_ps(_mm512_setzero_ps(), unvisited, idx, row, 4);
+            _mm512_storeu_ps(weights + k, w);
+            sum = _mm512_add_ps(sum, w);
+            open += std::popcount(static_cast<unsigned>(unvisited));
+        }
+
+        float total = _mm512_reduce_add_ps(sum);
+        int tailOpen = 0;
+        total += gatherWeightsScalar(row, indexes + k, visitedBits, count - k, weights + k, &tailOpen);
+        *feasible = open + tailOpen;
+        return total;
+    }
+
+    KERNELS_TARGET("avx512f")
+    static int rouletteSearchAVX512(const float* weights, int count, float target) {
+        const __m512 goal = _mm512_set1_ps(target);
+        const __m512 zero = _mm512_setzero_ps();
+        const __m512i lane = _mm512_set_epi32(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+        const __m512i lastLane = _mm512_set1_epi32(15);
+        __m512 offset = zero;
+        int k = 0;
+
+        for (; k + 16 <= count; k += 16) {
+            __m512 w = _mm512_loadu_ps(weights + k);
+
+            // Inclusive prefix sum: add the value d lanes to the left for d = 1, 2, 4, 8
+            __m512 t = w;
+            for (int d = 1; d < 16; d <<= 1) {
+                __m512i from = _mm512_sub_epi32(lane, _mm512_set1_epi32(d));
+                __mmask16 valid = _mm512_cmpge_epi32_mask(from, _mm512_setzero_si512());
+                t = _mm512_add_ps(t, _mm512_maskz_permutexvar_ps(valid, from, t));
+            }
+            t = _mm512_add_ps(t, offset);
+
+            __mmask16 hit = _mm512_cmp_ps_mask(t, goal, _CMP_GE_OQ) & _mm512_cmp_ps_mask(w, zero, _CMP_GT_OQ);
+            if (hit) {
+                return k + std::countr_zero(static_cast<unsigned>(hit));
+            }
+            offset = _mm512_permutexvar_ps(lastLane, t);
+        }
+
+        float cumulative = _mm512_cvtss_f32(offset);
+        for (; k < count; ++k) {
+            if (weights[k] > 0.0f) {
+                cumulative += weights[k];
+                if (cumulative >= target) {
+                    return k;
+                }
+            }
+        }
+        return -1;
+    }
+
+    KERNELS_TARGET("avx512f")
+    static void scaleAVX512(float* data, size_t count, float factor) {
+        const __m512 f = _mm512_set1_ps(factor);
+        size_t i = 0;
+        for (; i + 16 <= count; i += 16) {
+            _mm512_storeu_ps(data + i, _mm512_mul_ps(_mm512_loadu_ps(data + i), f));
+        }
+        scaleScalar(data + i, count - i, factor);
+    }
+
+    KERNELS_TARGET("avx512f")
+    static void distanceRowAVX512(float x, float y, const float* xs, const float* ys, float* out, size_t count) {
+        const __m512 vx = _mm512_set1_ps(x);
+        const __m512 vy = _mm512_set1_ps(y);
+        size_t k = 0;
+        for (; k + 16 <= count; k += 16) {
+            __m512 dx = _mm512_sub_ps(_mm512_loadu_ps(xs + k), vx);
+            __m512 dy = _mm512_sub_ps(_mm512_loadu_ps(ys + k), vy);
+            __m512 squared = _mm512_add_ps(_mm512_mul_ps(dx, dx), _mm512_mul_ps(dy, dy));
+            _mm512_storeu_ps(out + k, _mm512_sqrt_ps(squared));
+        }
+        distanceRowScalar(x, y, xs + k, ys + k, out + k, count - k);
+    }
+
+    KERNELS_TARGET("avx512f")
+    static inline void mulhiloAVX512(__m512i a, __m512i multiplier, __m512i& hi, __m512i& lo) {
+        __m512i even = _mm512_mul_epu32(a, multiplier);
+        __m512i odd = _mm512_mul_epu32(_mm512_srli_epi64(a, 32), multiplier);
+        lo = _mm512_mask_blend_epi32(0xAAAA, even, _mm512_slli_epi64(odd, 32));
+        hi = _mm512_mask_blend_epi32(0xAAAA, _mm512_srli_epi64(even, 32), odd);
+    }
+
+    KERNELS_TARGET("avx512f")
+    static inline __m512 uniformsAVX512(__m512i bits) {
+        return _mm512_mul_ps(_mm512_cvtepi32_ps(_mm512_srli_epi32(bits, 8)), _mm512_set1_ps(1.0f / 16777216.0f));
+    }
+
+    /*
+     * Sixteen Philox blocks per pass; the transpose ends with a 4 x 4 shuffle of 128-bit chunks
+     */
+    KERNELS_TARGET("avx512f")
+    static void philoxUniformsAVX512(const uint32_t* key, const uint32_t* tail, float* out, size_t count) {
+        const __m512i m0 = _mm512_set1_epi32(static_cast<int>(philox::multiplier0));
+        const __m512i m1 = _mm512_set1_epi32(static_cast<int>(philox::multiplier1));
+        const __m512i laneBlocks = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+
+        size_t s = 0;
+        for (; s + 64 <= count; s += 64) {
+            __m512i x0 = _mm512_add_epi32(_mm512_set1_epi32(static_cast<int>(s / 4)), laneBlocks);
+            __m512i x1 = _mm512_set1_epi32(static_cast<int>(tail[0]));
+            __m512i x2 = _mm512_set1_epi32(static_cast<int>(tail[1]));
+            __m512i x3 = _mm512_set1_epi32(static_cast<int>(tail[2]));
+            uint32_t k0 = key[0], k1 = key[1];
+
+            for (int round = 0; round < 10; ++round) {
+                __m512i hi0, lo0, hi1, lo1;
+                mulhiloAVX512(x0, m0, hi0, lo0);
+                mulhiloAVX512(x2, m1, hi1, lo1);
+                x0 = _mm512_xor_si512(_mm512_xor_si512(hi1, x1), _mm512_set1_epi32(static_cast<int>(k0)));
+                x1 = lo1;
+                x2 = _mm512_xor_si512(_mm512_xor_si512(hi0, x3), _mm512_set1_epi32(static_cast<int>(k1)));
+                x3 = lo0;
+                k0 += philox::weyl0;
+                k1 += philox::weyl1;
+            }
+
+            __m512i t0 = _mm512_unpacklo_epi32(x0, x1);
+            __m512i t1 = _mm512_unpacklo_epi32(x2, x3);
+            __m512i t2 = _mm512_unpackhi_epi32(x0, x1);
+            __m512i t3 = _mm512_unpackhi_epi32(x2, x3);
+            __m512i r0 = _mm512_unpacklo_epi64(t0, t1); // blocks 0 | 4 | 8 | 12
+            __m512i r1 = _mm512_unpackhi_epi64(t0, t1); // blocks 1 | 5 | 9 | 13
+            __m512i r2 = _mm512_unpacklo_epi64(t2, t3); // blocks 2 | 6 | 10 | 14
+            __m512i r3 = _mm512_unpackhi_epi64(t2, t3); // blocks 3 | 7 | 11 | 15
+
+            __m512i s0 = _mm512_shuffle_i32x4(r0, r1, _MM_SHUFFLE(2, 0, 2, 0)); // 0 | 8 | 1 | 9
+            __m512i s1 = _mm512_shuffle_i32x4(r2, r3, _MM_SHUFFLE(2, 0, 2, 0)); // 2 | 10 | 3 | 11
+            __m512i s2 = _mm512_shuffle_i32x4(r0, r1, _MM_SHUFFLE(3, 1, 3, 1)); // 4 | 12 | 5 | 13
+            __m512i s3 = _mm512_shuffle_i32x4(r2, r3, _MM_SHUFFLE(3, 1, 3, 1)); // 6 | 14 | 7 | 15
+
+            _mm512_storeu_ps(out + s, uniformsAVX512(_mm512_shuffle_i32x4(s0, s1, _MM_SHUFFLE(2, 0, 2, 0))));
+            _mm512_storeu_ps(out + s + 16, uniformsAVX512(_mm512_shuffle_i32x4(s2, s3, _MM_SHUFFLE(2, 0, 2, 0))));
+            _mm512_storeu_ps(out + s + 32, uniformsAVX512(_mm512_shuffle_i32x4(s0, s1, _MM_SHUFFLE(3, 1, 3, 1))));
+            _mm512_storeu_ps(out + s + 48, uniformsAVX512(_mm512_shuffle_i32x4(s2, s3, _MM_SHUFFLE(3, 1, 3, 1))));
+        }
+
+        philoxUniformsFrom(key, tail, s / 4, out + s, count - s);
+    }
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+#endif // KERNELS_X86
+
+    /*
+     * Runtime dispatch
+     */
+    static const KernelTable scalarTable{ SimdLevel::Scalar, gatherWeightsScalar, rouletteSearchScalar, scaleScalar,
+                                          distanceRowScalar, philoxUniformsScalar };
+#if KERNELS_X86
+    static const KernelTable avx2Table{ SimdLevel::AVX2, gatherWeightsAVX2, rouletteSearchAVX2, scaleAVX2,
+                                        distanceRowAVX2, philoxUniformsAVX2 };
+    static const KernelTable avx512Table{ SimdLevel::AVX512, gatherWeightsAVX512, rouletteSearchAVX512, scaleAVX512,
+                                          distanceRowAVX512, philoxUniformsAVX512 };
+#endif
+
+    static const KernelTable& tableFor(SimdLevel level) {
+#if KERNELS_X86
+        if (level == SimdLevel::AVX512) return avx512Table;
+        if (level == SimdLevel::AVX2) return avx2Table;
+#endif
+        return scalarTable;
+    }
+
+    SimdLevel detectSimdLevel() {
+#if KERNELS_X86 && defined(_MSC_VER) && !defined(__clang__)
+        int info[4];
+        __cpuid(info, 0);
+        int maxLeaf = info[0];
+        __cpuid(info, 1);
+        bool osxsave = (info[2] & (1 << 27)) != 0;
+        bool avx = (info[2] & (1 << 28)) != 0;
+        if (!osxsave || !avx || maxLeaf < 7) {
+            return SimdLevel::Scalar;
+        }
+
+        // The OS has to save the YMM (and for AVX-512 the ZMM/opmask) registers
+        unsigned long long xcr0 = _xgetbv(0);
+        __cpuidex(info, 7, 0);
+        bool avx2 = (info[1] & (1 << 5)) != 0 && (xcr0 & 0x6) == 0x6;
+        bool avx512 = (info[1] & (1 << 16)) != 0 && (xcr0 & 0xE6) == 0xE6;
+        if (avx512) return SimdLevel::AVX512;
+        if (avx2) return SimdLevel::AVX2;
+        return SimdLevel::Scalar;
+#elif KERNELS_X86
+        // Also checks that the OS enabled the wider register state
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f")) return SimdLevel::AVX512;
+        if (__builtin_cpu_supports("avx2")) return SimdLevel::AVX2;
+        return SimdLevel::Scalar;
+#else
+        return SimdLevel::Scalar;
+#endif
+    }
+
+    static std::atomic<const KernelTable*> current{ nullptr };
+
+    const KernelTable& active() {
+        const KernelTable* table = current.load(std::memory_order_acquire);
+        if (!table) {
+            table = &tableFor(detectSimdLevel());
+            current.store(table, std::memory_order_release);
+        }
+        return *table;
+    }
+
+    SimdLevel setSimdLevel(SimdLevel level) {
+        SimdLevel supported = detectSimdLevel();
+        if (static_cast<int>(level) > static_cast<int>(supported)) {
+            level = supported;
+        }
+        current.store(&tableFor(level), std::memory_order_release);
+        return level;
+    }
+
+    const char* simdLevelName(SimdLevel level) {
+        switch (level) {
+        case SimdLevel::AVX512: return "AVX-512";
+        case SimdLevel::AVX2: return "AVX2";
+        default: return "scalar";
+        }
+    }
+
+    void streamCopy(float* dst, const float* src, size_t count) {
+#if KERNELS_X86
+        size_t i = 0;
+        for (; i < count && (reinterpret_cast<uintptr_t>(dst + i) & 15) != 0; ++i) {
+            dst[i] = src[i];
+        }
+        for (; i + 4 <= count; i += 4) {
+            _mm_stream_ps(dst + i, _mm_loadu_ps(src + i));
+        }
+        for (; i < count; ++i) {
+            dst[i] = src[i];
+        }
+#else
+        std::memcpy(dst, src, count * sizeof(float));
+#endif
+    }
+
+    void streamFence() {
+#if KERNELS_X86
+        _mm_sfence();
+#endif
+    }
+}
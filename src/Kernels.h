@@ -0,0 +1,60 @@
+#ifndef KERNELS_H
+#define KERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Hot inner loops of tour construction and pheromone update
+// Scalar, AVX2 and AVX-512 versions live in one binary; the widest one the CPU
+// supports is picked through CPUID the first time the table is used
+namespace kernels {
+
+    enum class SimdLevel { Scalar, AVX2, AVX512 };
+
+    // Writes weights[k] = row[indexes[k]], or 0 when that city's bit is set in visitedBits
+    // Returns the sum of the weights and stores the number of unvisited cities in *feasible
+    using GatherWeightsFn = float (*)(const float* row, const int* indexes, const uint64_t* visitedBits,
+                                      int count, float* weights, int* feasible);
+
+    // Returns the first k with weights[k] > 0 whose running sum reaches target, or -1 if none does
+    using RouletteSearchFn = int (*)(const float* weights, int count, float target);
+
+    // data[i] *= factor for every i < count
+    using ScaleFn = void (*)(float* data, size_t count, float factor);
+
+    // out[k] = distance from (x, y) to (xs[k], ys[k]) for every k < count
+    using DistanceRowFn = void (*)(float x, float y, const float* xs, const float* ys, float* out, size_t count);
+
+    // out[s] = uniform [0, 1) float from word s % 4 of Philox4x32-10 block s / 4, where block b
+    // has counter { b, tail[0], tail[1], tail[2] } and the given 2-word key (see Philox.h)
+    // Every level produces the same bits
+    using PhiloxUniformsFn = void (*)(const uint32_t* key, const uint32_t* tail, float* out, size_t count);
+
+    struct KernelTable {
+        SimdLevel level;
+        GatherWeightsFn gatherWeights;
+        RouletteSearchFn rouletteSearch;
+        ScaleFn scale;
+        DistanceRowFn distanceRow;
+        PhiloxUniformsFn philoxUniforms;
+    };
+
+    // Widest instruction set supported by this CPU and operating system
+    SimdLevel detectSimdLevel();
+
+    // Kernels currently in use
+    const KernelTable& active();
+
+    // Switches to the given level, clamped to what the CPU supports; returns the level in use
+    SimdLevel setSimdLevel(SimdLevel level);
+
+    const char* simdLevelName(SimdLevel level);
+
+    // Copies count floats with non-temporal stores where the CPU has them (plain copy otherwise)
+    void streamCopy(float* dst, const float* src, size_t count);
+
+    // Orders this thread's streaming stores before any later synchronization
+    void streamFence();
+}
+
+#endif // KERNELS_H
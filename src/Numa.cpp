@@ -0,0 +1,355 @@
+#include "Numa.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <thread>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "Psapi.lib")
+#else
+#include <fstream>
+#include <sched.h>
+#include <unistd.h>
+#if defined(__linux__)
+#include <sys/syscall.h>
+#endif
+#endif
+
+namespace numa {
+
+    static vector<int> allCpus() {
+        vector<int> cpus(std::max(1u, std::thread::hardware_concurrency()));
+        for (size_t i = 0; i < cpus.size(); ++i) {
+            cpus[i] = static_cast<int>(i);
+        }
+        return cpus;
+    }
+
+#ifdef _WIN32
+    int nodeCount() {
+        ULONG highest = 0;
+        if (!GetNumaHighestNodeNumber(&highest)) {
+            return 1;
+        }
+        return static_cast<int>(highest) + 1;
+    }
+
+    // Group 0 only, i.e. the first 64 logical processors
+    vector<int> cpusOfNode(int node) {
+        ULONGLONG mask = 0;
+        if (!GetNumaNodeProcessorMask(static_cast<UCHAR>(node), &mask)) {
+            return node == 0 ? allCpus() : vector<int>{};
+        }
+        vector<int> cpus;
+        for (int cpu = 0; cpu < 64; ++cpu) {
+            if (mask & (1ull << cpu)) {
+                cpus.push_back(cpu);
+            }
+        }
+        return cpus;
+    }
+
+    int nodeOfCpu(int cpu) {
+        UCHAR node = 0;
+        if (cpu < 0 || cpu > 255 || !GetNumaProcessorNode(static_cast<UCHAR>(cpu), &node) || node == 0xFF) {
+            return 0;
+        }
+        return node;
+    }
+
+    bool pinCurrentThread(int cpu) {
+        if (cpu < 0 || cpu >= 64) {
+            return false;
+        }
+        return SetThreadAffinityMask(GetCurrentThread(), static_cast<DWORD_PTR>(1ull << cpu)) != 0;
+    }
+
+    // Win32 has no getter for a thread's mask: set the process mask and read back the old one
+    CpuMask currentAffinity() {
+        DWORD_PTR process = 0, system = 0;
+        if (!GetProcessAffinityMask(GetCurrentProcess(), &process, &system)) {
+            return {};
+        }
+        const DWORD_PTR mask = SetThreadAffinityMask(GetCurrentThread(), process);
+        if (mask == 0) {
+            return {};
+        }
+        SetThreadAffinityMask(GetCurrentThread(), mask);
+        return { static_cast<uint64_t>(mask) };
+    }
+
+    bool setCurrentAffinity(const CpuMask& mask) {
+        if (mask.empty() || mask[0] == 0) {
+            return false;
+        }
+        return SetThreadAffinityMask(GetCurrentThread(), static_cast<DWORD_PTR>(mask[0])) != 0;
+    }
+
+    vector<size_t> pagesPerNode(const void* data, size_t bytes) {
+        const int nodes = nodeCount();
+        vector<size_t> counts(nodes + 1, 0);
+        if (!data || bytes == 0) {
+            return counts;
+        }
+
+        SYSTEM_INFO info;
+        GetSystemInfo(&info);
+        const uintptr_t pageSize = info.dwPageSize;
+        const uintptr_t first = reinterpret_cast<uintptr_t>(data) / pageSize * pageSize;
+        const uintptr_t last = reinterpret_cast<uintptr_t>(data) + bytes;
+
+        vector<PSAPI_WORKING_SET_EX_INFORMATION> pages;
+        for (uintptr_t page = first; page < last; page += pageSize) {
+            PSAPI_WORKING_SET_EX_INFORMATION entry{};
+            entry.VirtualAddress = reinterpret_cast<PVOID>(page);
+            pages.push_back(entry);
+        }
+        if (!QueryWorkingSetEx(GetCurrentProcess(), pages.data(),
+                               static_cast<DWORD>(pages.size() * sizeof(PSAPI_WORKING_SET_EX_INFORMATION)))) {
+            return {};
+        }
+        for (const auto& entry : pages) {
+            int node = static_cast<int>(entry.VirtualAttributes.Node);
+            if (entry.VirtualAttributes.Valid && node < nodes) {
+                ++counts[node];
+            }
+            else {
+                ++counts[nodes];
+            }
+        }
+        return counts;
+    }
+#else
+    // Parses sysfs CPU lists such as "0-7,16-23"
+    static vector<int> parseCpuList(const string& text) {
+        vector<int> cpus;
+        size_t at = 0;
+        while (at < text.size()) {
+            size_t end = text.find(',', at);
+            if (end == string::npos) {
+                end = text.size();
+            }
+            string range = text.substr(at, end - at);
+            size_t dash = range.find('-');
+            try {
+                int lo = std::stoi(range.substr(0, dash));
+                int hi = dash == string::npos ? lo : std::stoi(range.substr(dash + 1));
+                for (int cpu = lo; cpu <= hi; ++cpu) {
+                    cpus.push_back(cpu);
+                }
+            }
+            catch (...) {
+                // Blank or malformed piece (e.g. trailing newline), skip it
+            }
+            at = end + 1;
+        }
+        return cpus;
+    }
+
+    static bool readCpuList(int node, vector<int>& cpus) {
+        ifstream file("/sys/devices/system/node/node" + to_string(node) + "/cpulist");
+        string text;
+        if (!file || !std::getline(file, text)) {
+            return false;
+        }
+        cpus = parseCpuList(text);
+        return true;
+    }
+
+    int nodeCount() {
+        static const int count = [] {
+            int nodes = 0;
+            vector<int> cpus;
+            while (readCpuList(nodes, cpus)) {
+                ++nodes;
+            }
+            return std::max(nodes, 1);
+        }();
+        return count;
+    }
+
+    vector<int> cpusOfNode(int node) {
+        vector<int> cpus;
+        if (!readCpuList(node, cpus)) {
+            return node == 0 ? allCpus() : vector<int>{};
+        }
+        return cpus;
+    }
+
+    int nodeOfCpu(int cpu) {
+        for (int node = 0; node < nodeCount(); ++node) {
+            vector<int> cpus = cpusOfNode(node);
+            if (std::find(cpus.begin(), cpus.end(), cpu) != cpus.end()) {
+                return node;
+            }
+        }
+        return 0;
+    }
+
+    bool pinCurrentThread(int cpu) {
+#if defined(__linux__)
+        if (cpu < 0 || cpu >= CPU_SETSIZE) {
+            return false;
+        }
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        return sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+        (void)cpu;
+        return false;
+#endif
+    }
+
+    CpuMask currentAffinity() {
+#if defined(__linux__)
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        if (sched_getaffinity(0, sizeof(set), &set) != 0) {
+            return {};
+        }
+        CpuMask mask((CPU_SETSIZE + 63) / 64, 0);
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+            if (CPU_ISSET(cpu, &set)) {
+                mask[cpu / 64] |= 1ull << (cpu % 64);
+            }
+        }
+        return mask;
+#else
+        return {};
+#endif
+    }
+
+    bool setCurrentAffinity(const CpuMask& mask) {
+#if defined(__linux__)
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        bool any = false;
+        for (int cpu = 0; cpu < CPU_SETSIZE && cpu / 64 < static_cast<int>(mask.size()); ++cpu) {
+            if (mask[cpu / 64] >> (cpu % 64) & 1) {
+                CPU_SET(cpu, &set);
+                any = true;
+            }
+        }
+        return any && sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+        (void)mask;
+        return false;
+#endif
+    }
+
+    // move_pages with a null target list only reports the node of every page
+    vector<size_t> pagesPerNode(const void* data, size_t bytes) {
+        const int nodes = nodeCount();
+        vector<size_t> counts(nodes + 1, 0);
+        if (!data || bytes == 0) {
+            return counts;
+        }
+#if defined(__linux__) && defined(SYS_move_pages)
+        const uintptr_t pageSize = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+        const uintptr_t first = reinterpret_cast<uintptr_t>(data) / pageSize * pageSize;
+        const uintptr_t last = reinterpret_cast<uintptr_t>(data) + bytes;
+
+        constexpr size_t batch = 4096;
+        vector<void*> pages;
+        vector<int> status(batch);
+        for (uintptr_t page = first; page < last;) {
+            pages.clear();
+            for (; page < last && pages.size() < batch; page += pageSize) {
+                pages.push_back(reinterpret_cast<void*>(page));
+            }
+            if (syscall(SYS_move_pages, 0, pages.size(), pages.data(), nullptr, status.data(), 0) != 0) {
+                return {};
+            }
+            for (size_t k = 0; k < pages.size(); ++k) {
+                if (status[k] >= 0 && status[k] < nodes) {
+                    ++counts[status[k]];
+                }
+                else {
+                    ++counts[nodes];
+                }
+            }
+        }
+        return counts;
+#else
+        return {};
+#endif
+    }
+#endif
+
+    ScopedPin::ScopedPin(int cpu) {
+        if (cpu < 0) {
+            return;
+        }
+        previous = currentAffinity();
+        pinned = !previous.empty() && pinCurrentThread(cpu);
+    }
+
+    ScopedPin::~ScopedPin() {
+        if (pinned) {
+            setCurrentAffinity(previous);
+        }
+    }
+
+    vector<int> pinningPlan(PinningPolicy policy, int threads) {
+        vector<int> plan;
+        if (policy == PinningPolicy::None || threads <= 0) {
+            return plan;
+        }
+
+        vector<vector<int>> byNode;
+        for (int node = 0; node < nodeCount(); ++node) {
+            vector<int> cpus = cpusOfNode(node);
+            if (!cpus.empty()) {
+                byNode.push_back(std::move(cpus));
+            }
+        }
+        if (byNode.empty()) {
+            byNode.push_back(allCpus());
+        }
+
+        // CPU order for one pass over the machine, then wrap around if the team is larger
+        vector<int> order;
+        if (policy == PinningPolicy::Compact) {
+            for (const auto& cpus : byNode) {
+                order.insert(order.end(), cpus.begin(), cpus.end());
+            }
+        }
+        else {
+            for (size_t k = 0; ; ++k) {
+                bool any = false;
+                for (const auto& cpus : byNode) {
+                    if (k < cpus.size()) {
+                        order.push_back(cpus[k]);
+                        any = true;
+                    }
+                }
+                if (!any) {
+                    break;
+                }
+            }
+        }
+
+        for (int t = 0; t < threads; ++t) {
+            plan.push_back(order[t % order.size()]);
+        }
+        return plan;
+    }
+
+    const char* pinningPolicyName(PinningPolicy policy) {
+        switch (policy) {
+        case PinningPolicy::Compact: return "compact";
+        case PinningPolicy::Scatter: return "scatter";
+        default: return "none";
+        }
+    }
+}
@@ -0,0 +1,69 @@
+#ifndef NUMA_H
+#define NUMA_H
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+using namespace std;
+
+// NUMA topology, thread pinning and page placement queries
+// Linux reads sysfs and uses sched_setaffinity / move_pages; Windows uses the Win32 NUMA API
+// Machines without NUMA information look like a single node holding every CPU
+namespace numa {
+
+    // How threads of a team are laid over the CPUs
+    enum class PinningPolicy {
+        None,    // Leave placement to the OS (or OMP_PROC_BIND / OMP_PLACES)
+        Compact, // Fill node 0's CPUs first, then node 1's, ...
+        Scatter  // Round-robin over the nodes, so every node gets an equal share of the team
+    };
+
+    int nodeCount();
+
+    // CPUs belonging to a node, ascending
+    vector<int> cpusOfNode(int node);
+
+    // Node of a CPU, 0 if unknown
+    int nodeOfCpu(int cpu);
+
+    // CPU for each of the team's threads under the given policy (empty for None)
+    vector<int> pinningPlan(PinningPolicy policy, int threads);
+
+    // Binds the calling thread to one CPU; returns false if the OS refused
+    bool pinCurrentThread(int cpu);
+
+    // CPUs a thread may run on, bit c of word c / 64 set for CPU c
+    using CpuMask = vector<uint64_t>;
+
+    // Affinity of the calling thread; empty if the OS cannot report it
+    CpuMask currentAffinity();
+
+    // Restores an affinity returned by currentAffinity; returns false if the OS refused
+    bool setCurrentAffinity(const CpuMask& mask);
+
+    // Pins the calling thread to one CPU for the guard's lifetime and then puts back the
+    // affinity it had before, so pooled and calling threads do not stay bound after a run
+    // A negative cpu leaves the thread alone
+    class ScopedPin {
+    public:
+        explicit ScopedPin(int cpu);
+        ~ScopedPin();
+
+        ScopedPin(const ScopedPin&) = delete;
+        ScopedPin& operator=(const ScopedPin&) = delete;
+
+    private:
+        CpuMask previous;
+        bool pinned = false;
+    };
+
+    // Number of pages of [data, data + bytes) resident on each node
+    // The extra last entry counts pages not yet touched (or whose node is unknown)
+    // Empty when the OS cannot report placement
+    vector<size_t> pagesPerNode(const void* data, size_t bytes);
+
+    const char* pinningPolicyName(PinningPolicy policy);
+}
+
+#endif // NUMA_H
@@ -0,0 +1,51 @@
+#ifndef PHILOX_H
+#define PHILOX_H
+
+#include <array>
+#include <cstdint>
+
+// Counter-based random numbers: Philox4x32-10 (Salmon et al., "Parallel random numbers:
+// as easy as 1, 2, 3", SC 2011)
+// A draw is a pure function of (key, counter), so there is no generator state to seed,
+// share or advance: whoever computes draw (iteration, ant, step) gets the same bits
+namespace philox {
+
+    using Counter = std::array<uint32_t, 4>;
+    using Key = std::array<uint32_t, 2>;
+
+    constexpr uint32_t multiplier0 = 0xD2511F53u;
+    constexpr uint32_t multiplier1 = 0xCD9E8D57u;
+    constexpr uint32_t weyl0 = 0x9E3779B9u; // Key schedule increments
+    constexpr uint32_t weyl1 = 0xBB67AE85u;
+
+    inline void mulhilo(uint32_t a, uint32_t b, uint32_t& hi, uint32_t& lo) {
+        uint64_t product = static_cast<uint64_t>(a) * b;
+        hi = static_cast<uint32_t>(product >> 32);
+        lo = static_cast<uint32_t>(product);
+    }
+
+    // Ten rounds of the Philox S-box over a 128-bit counter
+    inline Counter generate(Counter counter, Key key) {
+        for (int round = 0; round < 10; ++round) {
+            uint32_t hi0, lo0, hi1, lo1;
+            mulhilo(multiplier0, counter[0], hi0, lo0);
+            mulhilo(multiplier1, counter[2], hi1, lo1);
+            counter = { hi1 ^ counter[1] ^ key[0], lo1, hi0 ^ counter[3] ^ key[1], lo0 };
+            key[0] += weyl0;
+            key[1] += weyl1;
+        }
+        return counter;
+    }
+
+    // Top 24 bits as a float in [0, 1)
+    inline float toUniform(uint32_t bits) {
+        return static_cast<float>(bits >> 8) * (1.0f / 16777216.0f);
+    }
+
+    // Unbiased enough for city counts far below 2^32: floor(bits * range / 2^32)
+    inline uint32_t toRange(uint32_t bits, uint32_t range) {
+        return static_cast<uint32_t>((static_cast<uint64_t>(bits) * range) >> 32);
+    }
+}
+
+#endif // PHILOX_H
@@ -0,0 +1,382 @@
+#include "Transport.h"
+
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+
+// Thin shims over the two socket APIs: Winsock on Windows, BSD sockets everywhere else
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib, "Ws2_32.lib")
+
+using socket_t = SOCKET;
+using pollfd_t = WSAPOLLFD;
+static const socket_t invalidSocket = INVALID_SOCKET;
+static const int sendFlags = 0;
+
+static int pollSockets(pollfd_t* fds, size_t count, int timeoutMs) {
+    return WSAPoll(fds, static_cast<ULONG>(count), timeoutMs);
+}
+static void closeSocket(socket_t s) { closesocket(s); }
+static bool setNonBlocking(socket_t s) {
+    u_long mode = 1;
+    return ioctlsocket(s, FIONBIO, &mode) == 0;
+}
+static bool wouldBlock() { return WSAGetLastError() == WSAEWOULDBLOCK; }
+
+// Winsock has to be started once per process before any socket call
+static void startSockets() {
+    static const bool started = [] {
+        WSADATA data;
+        return WSAStartup(MAKEWORD(2, 2), &data) == 0;
+    }();
+    if (!started) {
+        throw runtime_error("TcpTransport: WSAStartup failed");
+    }
+}
+#else
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <cerrno>
+
+using socket_t = int;
+using pollfd_t = pollfd;
+static const socket_t invalidSocket = -1;
+#ifdef MSG_NOSIGNAL
+static const int sendFlags = MSG_NOSIGNAL; // A vanished peer must not raise SIGPIPE
+#else
+static const int sendFlags = 0;
+#endif
+
+static int pollSockets(pollfd_t* fds, size_t count, int timeoutMs) {
+    return ::poll(fds, static_cast<nfds_t>(count), timeoutMs);
+}
+static void closeSocket(socket_t s) { ::close(s); }
+static bool setNonBlocking(socket_t s) {
+    int flags = fcntl(s, F_GETFL, 0);
+    return flags >= 0 && fcntl(s, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+static bool wouldBlock() { return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR; }
+static void startSockets() {}
+#endif
+
+// Frame header: payload length (uint32), type (uint8), sender rank (int32), in host byte order
+static constexpr size_t frameHeaderSize = 9;
+
+static socket_t asSocket(intptr_t handle) { return static_cast<socket_t>(handle); }
+
+static sockaddr_in makeAddress(const string& host, int port) {
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(static_cast<uint16_t>(port));
+    if (inet_pton(AF_INET, host.c_str(), &address.sin_addr) != 1) {
+        throw runtime_error("TcpTransport: not an IPv4 address: " + host);
+    }
+    return address;
+}
+
+// Blocking exchange of the rank handshake, done before the sockets go non-blocking
+static bool sendAll(socket_t s, const void* data, size_t count) {
+    const char* bytes = static_cast<const char*>(data);
+    while (count > 0) {
+        auto sent = ::send(s, bytes, static_cast<int>(count), sendFlags);
+        if (sent <= 0) {
+            return false;
+        }
+        bytes += sent;
+        count -= static_cast<size_t>(sent);
+    }
+    return true;
+}
+
+static bool receiveAll(socket_t s, void* data, size_t count) {
+    char* bytes = static_cast<char*>(data);
+    while (count > 0) {
+        auto got = ::recv(s, bytes, static_cast<int>(count), 0);
+        if (got <= 0) {
+            return false;
+        }
+        bytes += got;
+        count -= static_cast<size_t>(got);
+    }
+    return true;
+}
+
+static bool isDroppable(MessageType type) {
+    return type == MessageType::BestTour || type == MessageType::PheromoneDelta;
+}
+
+/*
+ * Builds the full mesh
+ * - Listens first, so higher ranks can connect while this process is still dialing lower ones
+ * - Dials every lower rank (retrying until the deadline) and sends its own rank
+ * - Accepts every higher rank and reads theirs
+ */
+TcpTransport::TcpTransport(int rank, int size, int basePort, const string& host, double connectTimeoutSeconds)
+    : myRank(rank), worldSize(size), peers(size) {
+    if (size < 1 || rank < 0 || rank >= size) {
+        throw invalid_argument("TcpTransport: rank must be in [0, size)");
+    }
+    startSockets();
+    using clock_type = chrono::steady_clock;
+    const auto deadline = clock_type::now() + chrono::duration<double>(connectTimeoutSeconds);
+
+    if (rank < size - 1) {
+        socket_t s = ::socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+        if (s == invalidSocket) {
+            throw runtime_error("TcpTransport: cannot create listening socket");
+        }
+        int reuse = 1;
+        setsockopt(s, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&reuse), sizeof(reuse));
+        sockaddr_in address = makeAddress(host, basePort + rank);
+        if (::bind(s, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || ::listen(s, size) != 0) {
+            closeSocket(s);
+            throw runtime_error("TcpTransport: cannot listen on port " + to_string(basePort + rank));
+        }
+        listener = static_cast<intptr_t>(s);
+    }
+
+    for (int peer = 0; peer < rank; ++peer) {
+        sockaddr_in address = makeAddress(host, basePort + peer);
+        while (true) {
+            socket_t s = ::socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+            if (s != invalidSocket && ::connect(s, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0) {
+                int32_t me = rank;
+                if (!sendAll(s, &me, sizeof(me))) {
+                    closeSocket(s);
+                    throw runtime_error("TcpTransport: handshake with rank " + to_string(peer) + " failed");
+                }
+                peers[peer].socket = static_cast<intptr_t>(s);
+                break;
+            }
+            if (s != invalidSocket) {
+                closeSocket(s);
+            }
+            if (clock_type::now() > deadline) {
+                throw runtime_error("TcpTransport: rank " + to_string(peer) + " did not come up");
+            }
+            this_thread::sleep_for(chrono::milliseconds(100));
+        }
+    }
+
+    for (int accepted = rank + 1; accepted < size; ++accepted) {
+        pollfd_t waiting{};
+        waiting.fd = asSocket(listener);
+        waiting.events = POLLIN;
+        int remainingMs = static_cast<int>(chrono::duration_cast<chrono::milliseconds>(deadline - clock_type::now()).count());
+        if (remainingMs <= 0 || pollSockets(&waiting, 1, remainingMs) <= 0) {
+            throw runtime_error("TcpTransport: higher ranks did not connect in time");
+        }
+
+        socket_t s = ::accept(asSocket(listener), nullptr, nullptr);
+        int32_t from = -1;
+        if (s == invalidSocket || !receiveAll(s, &from, sizeof(from)) || from <= rank || from >= size
+            || peers[from].socket != -1) {
+            if (s != invalidSocket) {
+                closeSocket(s);
+            }
+            throw runtime_error("TcpTransport: bad handshake");
+        }
+        peers[from].socket = static_cast<intptr_t>(s);
+    }
+
+    for (int peer = 0; peer < size; ++peer) {
+        if (peer == rank) {
+            continue;
+        }
+        socket_t s = asSocket(peers[peer].socket);
+        int noDelay = 1;
+        setsockopt(s, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&noDelay), sizeof(noDelay));
+        setNonBlocking(s);
+        peers[peer].open = true;
+    }
+}
+
+TcpTransport::~TcpTransport() {
+    // Give queued output (final results) a short chance to leave before closing
+    using clock_type = chrono::steady_clock;
+    const auto deadline = clock_type::now() + chrono::seconds(2);
+    bool pending = true;
+    while (pending && clock_type::now() < deadline) {
+        pending = false;
+        for (auto& peer : peers) {
+            if (peer.open) {
+                flush(peer);
+                pending = pending || (peer.open && peer.outboundOffset < peer.outbound.size());
+            }
+        }
+        if (pending) {
+            this_thread::sleep_for(chrono::milliseconds(5));
+        }
+    }
+
+    for (auto& peer : peers) {
+        closePeer(peer);
+    }
+    if (listener != -1) {
+        closeSocket(asSocket(listener));
+    }
+}
+
+bool TcpTransport::send(int peerIndex, const Message& message) {
+    Peer& peer = peers[peerIndex];
+    if (!peer.open) {
+        ++counters.messagesDropped;
+        return false;
+    }
+
+    // A peer that stopped reading does not get to grow our memory or stall our sends
+    if (isDroppable(message.type) && peer.outbound.size() - peer.outboundOffset > maxQueuedBytes) {
+        ++counters.messagesDropped;
+        return false;
+    }
+
+    uint32_t length = static_cast<uint32_t>(message.payload.size());
+    uint8_t type = static_cast<uint8_t>(message.type);
+    int32_t from = myRank;
+    size_t at = peer.outbound.size();
+    peer.outbound.resize(at + frameHeaderSize + length);
+    std::memcpy(peer.outbound.data() + at, &length, 4);
+    std::memcpy(peer.outbound.data() + at + 4, &type, 1);
+    std::memcpy(peer.outbound.data() + at + 5, &from, 4);
+    if (length > 0) {
+        std::memcpy(peer.outbound.data() + at + frameHeaderSize, message.payload.data(), length);
+    }
+
+    ++counters.messagesSent;
+    counters.bytesSent += frameHeaderSize + length;
+    flush(peer);
+    return true;
+}
+
+/*
+ * Writes as much queued output as the kernel takes right now
+ */
+void TcpTransport::flush(Peer& peer) {
+    while (peer.open && peer.outboundOffset < peer.outbound.size()) {
+        size_t count = peer.outbound.size() - peer.outboundOffset;
+        auto sent = ::send(asSocket(peer.socket),
+                           reinterpret_cast<const char*>(peer.outbound.data() + peer.outboundOffset),
+                           static_cast<int>(count), sendFlags);
+        if (sent > 0) {
+            peer.outboundOffset += static_cast<size_t>(sent);
+        }
+        else if (sent < 0 && wouldBlock()) {
+            return;
+        }
+        else {
+            closePeer(peer);
+            return;
+        }
+    }
+    peer.outbound.clear();
+    peer.outboundOffset = 0;
+}
+
+/*
+ * Reads everything available from one peer and splits it into messages
+ */
+void TcpTransport::receive(int index) {
+    Peer& peer = peers[index];
+    uint8_t buffer[64 * 1024];
+    while (peer.open) {
+        auto got = ::recv(asSocket(peer.socket), reinterpret_cast<char*>(buffer), static_cast<int>(sizeof(buffer)), 0);
+        if (got > 0) {
+            peer.inbound.insert(peer.inbound.end(), buffer, buffer + got);
+            counters.bytesReceived += static_cast<uint64_t>(got);
+            continue;
+        }
+        if (got < 0 && wouldBlock()) {
+            break;
+        }
+        closePeer(peer);
+        break;
+    }
+
+    size_t at = 0;
+    while (peer.inbound.size() - at >= frameHeaderSize) {
+        uint32_t length;
+        std::memcpy(&length, peer.inbound.data() + at, 4);
+        if (peer.inbound.size() - at < frameHeaderSize + length) {
+            break;
+        }
+        Message message;
+        message.type = static_cast<MessageType>(peer.inbound[at + 4]);
+        std::memcpy(&message.from, peer.inbound.data() + at + 5, 4);
+        message.payload.assign(peer.inbound.begin() + at + frameHeaderSize,
+                               peer.inbound.begin() + at + frameHeaderSize + length);
+        ready.push_back(std::move(message));
+        ++counters.messagesReceived;
+        at += frameHeaderSize + length;
+    }
+    peer.inbound.erase(peer.inbound.begin(), peer.inbound.begin() + at);
+}
+
+bool TcpTransport::poll(Message& message, int timeoutMs) {
+    if (ready.empty()) {
+        vector<pollfd_t> fds;
+        vector<int> owners;
+        for (int i = 0; i < worldSize; ++i) {
+            Peer& peer = peers[i];
+            if (!peer.open) {
+                continue;
+            }
+            flush(peer);
+            if (!peer.open) {
+                continue;
+            }
+            pollfd_t entry{};
+            entry.fd = asSocket(peer.socket);
+            entry.events = POLLIN;
+            if (peer.outboundOffset < peer.outbound.size()) {
+                entry.events |= POLLOUT;
+            }
+            fds.push_back(entry);
+            owners.push_back(i);
+        }
+
+        if (fds.empty()) {
+            if (timeoutMs > 0) {
+                this_thread::sleep_for(chrono::milliseconds(timeoutMs));
+            }
+        }
+        else if (pollSockets(fds.data(), fds.size(), timeoutMs) > 0) {
+            for (size_t k = 0; k < fds.size(); ++k) {
+                if (fds[k].revents & (POLLIN | POLLERR | POLLHUP)) {
+                    receive(owners[k]);
+                }
+                if (fds[k].revents & POLLOUT) {
+                    flush(peers[owners[k]]);
+                }
+            }
+        }
+    }
+
+    if (ready.empty()) {
+        return false;
+    }
+    message = std::move(ready.front());
+    ready.pop_front();
+    return true;
+}
+
+void TcpTransport::closePeer(Peer& peer) {
+    if (peer.socket != -1) {
+        closeSocket(asSocket(peer.socket));
+        peer.socket = -1;
+    }
+    peer.open = false;
+}
@@ -0,0 +1,112 @@
+#ifndef TRANSPORT_H
+#define TRANSPORT_H
+
+#include <vector>
+#include <deque>
+#include <string>
+#include <cstdint>
+
+using namespace std;
+
+// Kinds of message exchanged between distributed colonies
+enum class MessageType : uint8_t {
+    BestTour = 1,       // A peer's best tour: length + city order
+    PheromoneDelta = 2, // A peer's compressed pheromone changes since its last exchange
+    Done = 3,           // Worker -> coordinator: finished, with its best tour
+    Stop = 4,           // Coordinator -> all: stop iterating and report
+    GlobalBest = 5      // Coordinator -> all: final global best tour
+};
+
+struct Message {
+    MessageType type = MessageType::Done;
+    int32_t from = 0;
+    vector<uint8_t> payload;
+};
+
+// Traffic counters of one process
+struct TransportStats {
+    uint64_t messagesSent = 0;
+    uint64_t messagesReceived = 0;
+    uint64_t bytesSent = 0;
+    uint64_t bytesReceived = 0;
+    uint64_t messagesDropped = 0; // Droppable messages discarded because a peer fell behind
+};
+
+// Point-to-point message transport between the processes of one distributed solve
+// Processes are numbered 0..size-1; rank 0 acts as the coordinator
+class Transport {
+public:
+    virtual ~Transport() = default;
+
+    virtual int rank() const = 0;
+    virtual int size() const = 0;
+
+    // Queues a message for a peer without blocking
+    // Returns false when the message was dropped (peer gone or too far behind)
+    virtual bool send(int peer, const Message& message) = 0;
+
+    // Pushes queued output and reads input, waiting at most timeoutMs for something to arrive
+    // Returns true and fills message when a complete message is available
+    virtual bool poll(Message& message, int timeoutMs) = 0;
+
+    virtual const TransportStats& stats() const = 0;
+
+    // False once the connection to a peer has failed or been closed
+    virtual bool connected(int peer) const = 0;
+
+    // Queues a message for every other process
+    void broadcast(const Message& message) {
+        for (int peer = 0; peer < size(); ++peer) {
+            if (peer != rank()) {
+                send(peer, message);
+            }
+        }
+    }
+};
+
+// Full mesh of TCP connections between processes on one host (or reachable hosts)
+// Process r listens on basePort + r, connects to every lower rank and accepts every higher one
+// Sockets are non-blocking and every peer has its own output queue, so a slow reader only
+// delays itself: once its queue passes maxQueuedBytes, droppable messages to it are discarded
+class TcpTransport : public Transport {
+public:
+    TcpTransport(int rank, int size, int basePort, const string& host = "127.0.0.1",
+                 double connectTimeoutSeconds = 30.0);
+    ~TcpTransport() override;
+
+    TcpTransport(const TcpTransport&) = delete;
+    TcpTransport& operator=(const TcpTransport&) = delete;
+
+    int rank() const override { return myRank; }
+    int size() const override { return worldSize; }
+    bool send(int peer, const Message& message) override;
+    bool poll(Message& message, int timeoutMs) override;
+    const TransportStats& stats() const override { return counters; }
+    bool connected(int peer) const override { return peers[peer].open; }
+
+    // Output queued for one peer beyond which droppable messages are discarded
+    size_t maxQueuedBytes = size_t(8) << 20;
+
+private:
+    // Socket handles are stored as intptr_t so this header does not need the socket headers
+    struct Peer {
+        intptr_t socket = -1;
+        vector<uint8_t> outbound; // Framed bytes not yet accepted by the kernel
+        size_t outboundOffset = 0;
+        vector<uint8_t> inbound;  // Bytes received but not yet parsed into messages
+        bool open = false;
+    };
+
+    int myRank;
+    int worldSize;
+    intptr_t listener = -1;
+    vector<Peer> peers;
+    deque<Message> ready;
+    TransportStats counters;
+
+    void flush(Peer& peer);
+    void receive(int index);
+    void closePeer(Peer& peer);
+};
+
+#endif // TRANSPORT_H
@@ -0,0 +1,162 @@
+#ifndef WEIGHTS_H
+#define WEIGHTS_H
+
+#include <cstddef>
+#include <cmath>
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <limits>
+
+// Selection weight kernels tau^alpha * eta^beta
+// Common integer exponent pairs get their own instantiation where the power is a few
+// multiplies; any other alpha/beta goes through a polynomial exp2/log2 approximation
+namespace weights {
+
+    // x^N unrolled at compile time by repeated squaring
+    template<int N>
+    inline float integerPow(float x) {
+        if constexpr (N == 0) {
+            return 1.0f;
+        }
+        else if constexpr (N % 2 == 0) {
+            float half = integerPow<N / 2>(x);
+            return half * half;
+        }
+        else {
+            return x * integerPow<N - 1>(x);
+        }
+    }
+
+    // log2(x) for normal positive x, without a libm call
+    // x = m * 2^k with m in [sqrt(1/2), sqrt(2)); log2(m) from the atanh series in t = (m-1)/(m+1),
+    // |t| <= 0.172, truncated after t^7 (the next term is below 3e-8)
+    inline float fastLog2(float x) {
+        const uint32_t bits = std::bit_cast<uint32_t>(x);
+        // Re-bias so the mantissa lands in [sqrt(1/2), sqrt(2)) instead of [1, 2)
+        const uint32_t shifted = bits - 0x3F3504F3u;
+        const int exponent = static_cast<int32_t>(shifted) >> 23;
+        const float m = std::bit_cast<float>((shifted & 0x007FFFFFu) + 0x3F3504F3u);
+
+        const float t = (m - 1.0f) / (m + 1.0f);
+        const float t2 = t * t;
+        const float series = t * (2.0f + t2 * (2.0f / 3.0f + t2 * (2.0f / 5.0f + t2 * (2.0f / 7.0f))));
+        return static_cast<float>(exponent) + series * 1.44269504f; // series is ln(m)
+    }
+
+    // 2^y without a libm call; results below 2^-126 flush to zero and y >= 128 saturates near FLT_MAX
+    // y = k + f with f in [-1/2, 1/2]; 2^f from the Taylor series of e^(f ln 2) up to the 6th power
+    // (the next term is below 1.3e-7 relative); 2^k is applied as two halves so k = 128 stays finite
+    inline float fastExp2(float y) {
+        float clamped = y > -126.0f ? y : -126.0f;
+        clamped = clamped < 127.99998f ? clamped : 127.99998f;
+        const float k = (clamped + 12582912.0f) - 12582912.0f; // Round to nearest, 12582912 = 1.5 * 2^23
+        const float z = (clamped - k) * 0.693147181f;
+        const float p = 1.0f + z * (1.0f + z * (1.0f / 2.0f + z * (1.0f / 6.0f + z * (1.0f / 24.0f
+            + z * (1.0f / 120.0f + z * (1.0f / 720.0f))))));
+        const int32_t kLow = static_cast<int32_t>(k) >> 1;
+        const int32_t kHigh = static_cast<int32_t>(k) - kLow;
+        const float value = p * std::bit_cast<float>(static_cast<uint32_t>(kLow + 127) << 23)
+            * std::bit_cast<float>(static_cast<uint32_t>(kHigh + 127) << 23);
+        return y > -126.0f ? value : 0.0f;
+    }
+
+    // x^e for x = 0 or a normal positive float, as fastExp2(e * fastLog2(x)); zero stays zero for positive e
+    // Straight-line float arithmetic with no libm call, so the generic row loops can vectorize
+    // (about 9x faster than a std::pow loop with GCC -O3 and AVX-512).
+    // Relative error against a double-precision pow is below 3e-7 * (1 + |e * log2 x|), so about 4e-5
+    // at the very ends of the float range; results under 2^-126 are 0
+    inline float genericPow(float x, float e) {
+        // Computed unconditionally and selected afterwards, which keeps the loops branch-free
+        const float atZero = e == 0.0f ? 1.0f : 0.0f;
+        const float value = fastExp2(e * fastLog2(x));
+        return x > 0.0f ? value : atZero;
+    }
+
+    // out[j] = tau[j]^alpha * etaBeta[j]
+    using ChoiceRowFn = void (*)(const float* tau, const float* etaBeta, float* out, std::size_t n, float alpha);
+
+    // out[j] = (1 / distance[j])^beta
+    using HeuristicRowFn = void (*)(const float* distance, float* out, std::size_t n, float beta);
+
+    // tau^alpha for a single value, for paths that are not served by the cached matrices
+    using PheromoneWeightFn = float (*)(float tau, float alpha);
+
+    struct WeightKernel {
+        ChoiceRowFn choiceRow;
+        HeuristicRowFn heuristicRow;
+        PheromoneWeightFn pheromoneWeight;
+        bool specialized; // False when alpha/beta fell back to the generic path
+    };
+
+    template<int Alpha, int Beta>
+    struct IntegerExponents {
+        static void choiceRow(const float* tau, const float* etaBeta, float* out, std::size_t n, float) {
+            for (std::size_t j = 0; j < n; ++j) {
+                out[j] = integerPow<Alpha>(tau[j]) * etaBeta[j];
+            }
+        }
+
+        static void heuristicRow(const float* distance, float* out, std::size_t n, float) {
+            for (std::size_t j = 0; j < n; ++j) {
+                out[j] = integerPow<Beta>(1.0f / std::max(distance[j], 1e-6f));
+            }
+        }
+
+        static float pheromoneWeight(float tau, float) {
+            return integerPow<Alpha>(tau);
+        }
+
+        static constexpr WeightKernel kernel{ choiceRow, heuristicRow, pheromoneWeight, true };
+    };
+
+    struct GenericExponents {
+        static void choiceRow(const float* tau, const float* etaBeta, float* out, std::size_t n, float alpha) {
+            for (std::size_t j = 0; j < n; ++j) {
+                out[j] = genericPow(tau[j], alpha) * etaBeta[j];
+            }
+        }
+
+        static void heuristicRow(const float* distance, float* out, std::size_t n, float beta) {
+            for (std::size_t j = 0; j < n; ++j) {
+                out[j] = genericPow(1.0f / std::max(distance[j], 1e-6f), beta);
+            }
+        }
+
+        static float pheromoneWeight(float tau, float alpha) {
+            return genericPow(tau, alpha);
+        }
+
+        static constexpr WeightKernel kernel{ choiceRow, heuristicRow, pheromoneWeight, false };
+    };
+
+    // Instantiations for alpha in 1..3 and beta in 1..6
+    template<int Alpha>
+    inline const WeightKernel* forBeta(int beta) {
+        switch (beta) {
+        case 1: return &IntegerExponents<Alpha, 1>::kernel;
+        case 2: return &IntegerExponents<Alpha, 2>::kernel;
+        case 3: return &IntegerExponents<Alpha, 3>::kernel;
+        case 4: return &IntegerExponents<Alpha, 4>::kernel;
+        case 5: return &IntegerExponents<Alpha, 5>::kernel;
+        case 6: return &IntegerExponents<Alpha, 6>::kernel;
+        default: return nullptr;
+        }
+    }
+
+    // Picks the specialized kernel when alpha and beta are both small integers
+    inline const WeightKernel& selectKernel(float alpha, float beta) {
+        const WeightKernel* kernel = nullptr;
+        if (alpha == std::floor(alpha) && beta == std::floor(beta)) {
+            switch (static_cast<int>(alpha)) {
+            case 1: kernel = forBeta<1>(static_cast<int>(beta)); break;
+            case 2: kernel = forBeta<2>(static_cast<int>(beta)); break;
+            case 3: kernel = forBeta<3>(static_cast<int>(beta)); break;
+            default: break;
+            }
+        }
+        return kernel ? *kernel : GenericExponents::kernel;
+    }
+}
+
+#endif // WEIGHTS_H
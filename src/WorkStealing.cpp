@@ -0,0 +1,143 @@
+#include "WorkStealing.h"
+
+#include <chrono>
+#include <thread>
+
+WorkStealingScheduler::WorkStealingScheduler(int workers)
+    : workerStats(workers > 0 ? workers : 1) {
+    queues.resize(workerStats.size());
+    for (auto& queue : queues) {
+        queue = make_unique<WorkerQueue>();
+    }
+}
+
+/*
+ * Adds a task to the back of a worker's deque
+ * - pending is raised first so no worker can see an empty system while the task is in flight
+ */
+void WorkStealingScheduler::push(int worker, SchedulerTask task) {
+    pending.fetch_add(1, memory_order_relaxed);
+    WorkerQueue& queue = *queues[worker];
+    lock_guard<mutex> guard(queue.lock);
+    queue.tasks.push_back(task);
+}
+
+/*
+ * Deals out tasks 0..count-1 in contiguous blocks, like schedule(static) would
+ */
+void WorkStealingScheduler::seedBlocks(int count, int kind) {
+    const int workers = workerCount();
+    for (int w = 0; w < workers; ++w) {
+        int begin = static_cast<int>(static_cast<int64_t>(count) * w / workers);
+        int end = static_cast<int>(static_cast<int64_t>(count) * (w + 1) / workers);
+        for (int i = begin; i < end; ++i) {
+            push(w, { kind, i });
+        }
+    }
+}
+
+bool WorkStealingScheduler::popLocal(int worker, SchedulerTask& task) {
+    WorkerQueue& queue = *queues[worker];
+    lock_guard<mutex> guard(queue.lock);
+    if (queue.tasks.empty()) {
+        return false;
+    }
+    task = queue.tasks.back();
+    queue.tasks.pop_back();
+    return true;
+}
+
+/*
+ * Tries every other worker once, starting from a random victim
+ * - Steals from the front, the oldest task and the one the owner will reach last
+ */
+bool WorkStealingScheduler::steal(int worker, uint64_t& seed, SchedulerTask& task) {
+    const int workers = workerCount();
+
+    // xorshift64 for the starting victim
+    seed ^= seed << 13;
+    seed ^= seed >> 7;
+    seed ^= seed << 17;
+    int start = static_cast<int>(seed % static_cast<uint64_t>(workers));
+
+    for (int k = 0; k < workers; ++k) {
+        int victim = (start + k) % workers;
+        if (victim == worker) {
+            continue;
+        }
+
+        WorkerQueue& queue = *queues[victim];
+        lock_guard<mutex> guard(queue.lock);
+        if (!queue.tasks.empty()) {
+            task = queue.tasks.front();
+            queue.tasks.pop_front();
+            ++workerStats[worker].steals;
+            return true;
+        }
+        ++workerStats[worker].failedSteals;
+    }
+    return false;
+}
+
+/*
+ * Worker loop: own deque first, then steal, until nothing is pending anywhere
+ */
+void WorkStealingScheduler::run(int worker, const function<void(SchedulerTask, int)>& execute) {
+    using clock_type = chrono::steady_clock;
+    WorkerStats& mine = workerStats[worker];
+    uint64_t seed = 0x9E3779B97F4A7C15ull * static_cast<uint64_t>(worker + 1);
+
+    while (true) {
+        SchedulerTask task;
+        if (popLocal(worker, task) || steal(worker, seed, task)) {
+            execute(task, worker);
+            ++mine.tasksRun;
+            pending.fetch_sub(1, memory_order_acq_rel);
+            continue;
+        }
+
+        // Nothing to take: wait until work shows up or everything is finished
+        auto idleStart = clock_type::now();
+        bool finished = false;
+        while (true) {
+            if (pending.load(memory_order_acquire) == 0) {
+                finished = true;
+                break;
+            }
+            if (popLocal(worker, task) || steal(worker, seed, task)) {
+                break;
+            }
+            this_thread::yield();
+        }
+        mine.idleSeconds += chrono::duration<double>(clock_type::now() - idleStart).count();
+
+        if (finished) {
+            return;
+        }
+        execute(task, worker);
+        ++mine.tasksRun;
+        pending.fetch_sub(1, memory_order_acq_rel);
+    }
+}
+
+uint64_t WorkStealingScheduler::totalSteals() const {
+    uint64_t total = 0;
+    for (const auto& s : workerStats) {
+        total += s.steals;
+    }
+    return total;
+}
+
+double WorkStealingScheduler::totalIdleSeconds() const {
+    double total = 0.0;
+    for (const auto& s : workerStats) {
+        total += s.idleSeconds;
+    }
+    return total;
+}
+
+void WorkStealingScheduler::resetStats() {
+    for (auto& s : workerStats) {
+        s = WorkerStats{};
+    }
+}
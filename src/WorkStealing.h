@@ -0,0 +1,70 @@
+#ifndef WORK_STEALING_H
+#define WORK_STEALING_H
+
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <functional>
+#include <cstdint>
+
+using namespace std;
+
+// A unit of work: what to do (kind) and which item (usually an ant index) to do it to
+struct SchedulerTask {
+    int kind;
+    int index;
+};
+
+// Load-balance counters of one worker
+struct WorkerStats {
+    uint64_t tasksRun = 0;  // Tasks executed by this worker
+    uint64_t steals = 0;    // Tasks taken from another worker's deque
+    uint64_t failedSteals = 0; // Steal attempts that found the victim empty
+    double idleSeconds = 0.0; // Time spent looking for work
+};
+
+// Work-stealing scheduler for the threads of a parallel team
+// Every worker owns a deque: it pushes and pops at the back, and when it runs
+// dry it steals from the front of a random victim's deque
+class WorkStealingScheduler {
+public:
+    explicit WorkStealingScheduler(int workers);
+
+    int workerCount() const { return static_cast<int>(queues.size()); }
+
+    // Adds a task to a worker's deque; safe to call from inside a running task
+    void push(int worker, SchedulerTask task);
+
+    // Deals tasks 0..count-1 of the given kind out in contiguous blocks, one block per worker
+    // Must be called before the workers start running
+    void seedBlocks(int count, int kind);
+
+    // Executes tasks until every task, including ones spawned meanwhile, has finished
+    // Called by every worker of the team with its own worker index
+    void run(int worker, const function<void(SchedulerTask, int)>& execute);
+
+    // Per-worker counters, accumulated over every run
+    const vector<WorkerStats>& stats() const { return workerStats; }
+
+    uint64_t totalSteals() const;
+    double totalIdleSeconds() const;
+    void resetStats();
+
+private:
+    // Deque and lock of one worker, on its own cache lines
+    struct alignas(64) WorkerQueue {
+        mutex lock;
+        deque<SchedulerTask> tasks;
+    };
+
+    vector<unique_ptr<WorkerQueue>> queues;
+    vector<WorkerStats> workerStats;
+    atomic<int64_t> pending{ 0 }; // Tasks pushed but not yet finished
+
+    bool popLocal(int worker, SchedulerTask& task);
+    bool steal(int worker, uint64_t& seed, SchedulerTask& task);
+};
+
+#endif // WORK_STEALING_H
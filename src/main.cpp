@@ -54,6 +54,9 @@ int main() {
     }
     
 
+    // Random number generator for city placement and ant starts
+    mt19937 rng(static_cast<unsigned>(time(nullptr)));
+
     vector<shared_ptr<city>> cities;
     const float margin = 1000 / numberOfCities; // Minimum space between cities
     uniform_real_distribution<> dis_width(0, (WIDTH / 2));
@@ -112,8 +115,8 @@ int main() {
         // Setup the ant at the start of a route
             if (ant->route.empty()) {
                 uniform_int_distribution<int> antStart(0, cities.size()-1);
-                ant->visitCity(cities[antStart(rng)]);
-                ant->position = ant->currCity->position;
+                ant->visitCity(antStart(rng));
+                ant->position = cities[ant->currCity]->position;
                 antGraphics.setAnt(ant);
             }
 
@@ -126,9 +129,8 @@ int main() {
               
               if(ant->route.size() != cities.size()+1){
                 //Next Steop on ant if route hasnt visted every city
-                aco.step(ant);
+                aco.step(*ant);
               }else{
-                ant->clearCitys();
                 ++currAnt;
                 if (currAnt < numAnts) {
                     ant = ants[currAnt];
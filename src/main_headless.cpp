@@ -3,10 +3,15 @@
 #include "Ant.h"
 #include "ACO.h"
 #include "test.h"
+#include "WorkStealing.h"
+#include "IslandModel.h"
+#include "DistributedRunner.h"
 
+#include <cstring>
+#include <cstdlib>
 
 
-int main() {
+int main(int argc, char** argv) {
     int   numAnts = 20;
     int   numberOfCities = 30;
     int   iterations = 50;
@@ -15,6 +20,91 @@ int main() {
     float alpha = 1.0f;
     float beta = 5.0f;
 
+    // --stress: run the concurrent solver check afterwards
+    // --islands N: also run an N-colony island model on the same cities
+    //   (with --distributed: colonies per process, default 2)
+    // --distributed RANK SIZE: run as one process of a distributed solve instead
+    //   (start SIZE copies, ranks 0..SIZE-1; --port sets the first TCP port)
+    // --iterations N: iterations of every run
+    // --async-bench: compare the synchronous, asynchronous and pipelined update modes
+    // --pipelined: overlap each iteration's pheromone update with the next construction
+    // --local-search: improve every tour with 2-opt before it is deposited
+    // --backend sequential|openmp|threadpool|stdpar: run the solve on that execution backend
+    // --backend-bench: time the same solve on every backend
+    // --pin compact|scatter: pin the solver's threads; --replicas: per-node choice copies
+    // --numa-report: print where the matrices' pages live
+    // --startup-bench: time instance construction over a range of sizes
+    // --deterministic: force sort-reduce deposits and check that run() is bit-identical for 1..8 threads,
+    //   and for a StepTeam-shared solve of a larger instance
+    bool stress = false;
+    bool deterministic = false;
+    bool startupBench = false;
+    bool asyncBench = false;
+    bool pipelined = false;
+    bool localSearch = false;
+    BackendKind backendKind = BackendKind::OpenMP;
+    bool backendBench = false;
+    numa::PinningPolicy pinning = numa::PinningPolicy::None;
+    bool replicas = false;
+    bool numaReport = false;
+    int islands = 0;
+    int rank = -1;
+    int worldSize = 0;
+    int basePort = 47000;
+    for (int a = 1; a < argc; ++a) {
+        if (std::strcmp(argv[a], "--stress") == 0) {
+            stress = true;
+        }
+        else if (std::strcmp(argv[a], "--async-bench") == 0) {
+            asyncBench = true;
+        }
+        else if (std::strcmp(argv[a], "--pipelined") == 0) {
+            pipelined = true;
+        }
+        else if (std::strcmp(argv[a], "--local-search") == 0) {
+            localSearch = true;
+        }
+        else if (std::strcmp(argv[a], "--backend") == 0 && a + 1 < argc) {
+            if (!parseBackendKind(argv[++a], backendKind)) {
+                std::cerr << "Unknown backend " << argv[a] << ", using " << backendName(backendKind) << "\n";
+            }
+        }
+        else if (std::strcmp(argv[a], "--backend-bench") == 0) {
+            backendBench = true;
+        }
+        else if (std::strcmp(argv[a], "--pin") == 0 && a + 1 < argc) {
+            ++a;
+            pinning = std::strcmp(argv[a], "scatter") == 0 ? numa::PinningPolicy::Scatter
+                    : std::strcmp(argv[a], "compact") == 0 ? numa::PinningPolicy::Compact
+                    : numa::PinningPolicy::None;
+        }
+        else if (std::strcmp(argv[a], "--deterministic") == 0) {
+            deterministic = true;
+        }
+        else if (std::strcmp(argv[a], "--startup-bench") == 0) {
+            startupBench = true;
+        }
+        else if (std::strcmp(argv[a], "--replicas") == 0) {
+            replicas = true;
+        }
+        else if (std::strcmp(argv[a], "--numa-report") == 0) {
+            numaReport = true;
+        }
+        else if (std::strcmp(argv[a], "--islands") == 0 && a + 1 < argc) {
+            islands = std::atoi(argv[++a]);
+        }
+        else if (std::strcmp(argv[a], "--distributed") == 0 && a + 2 < argc) {
+            rank = std::atoi(argv[++a]);
+            worldSize = std::atoi(argv[++a]);
+        }
+        else if (std::strcmp(argv[a], "--port") == 0 && a + 1 < argc) {
+            basePort = std::atoi(argv[++a]);
+        }
+        else if (std::strcmp(argv[a], "--iterations") == 0 && a + 1 < argc) {
+            iterations = std::atoi(argv[++a]);
+        }
+    }
+
     // Generate random cities
     std::vector<std::shared_ptr<city>> cities;
     std::mt19937 gen(12345);
@@ -28,100 +118,135 @@ int main() {
         ));
     }
 
+    if (worldSize > 0) {
+        DistributedConfig config;
+        config.colonies.islands = islands > 0 ? islands : 2;
+        config.colonies.antsPerIsland = numAnts;
+        config.colonies.Q = Q;
+        config.colonies.evaporationRate = evaporationRate;
+        config.colonies.alpha = alpha;
+        config.colonies.beta = beta;
+        config.iterations = iterations;
+
+        TcpTransport transport(rank, worldSize, basePort);
+        DistributedRunner runner(cities, transport, config);
+
+        using clock_type = std::chrono::steady_clock;
+        auto t_start = clock_type::now();
+        runner.run();
+        std::chrono::duration<double> elapsed = clock_type::now() - t_start;
+
+        std::cout << "Distributed run time: " << elapsed.count() << " s\n";
+        runner.printReport(std::cout);
+        return 0;
+    }
+
     // Build ACO object
     ACO aco(cities, numAnts, Q, evaporationRate);
     aco.setAlpha(alpha);
     aco.setBeta(beta);
-
-    auto& ants = aco.getAnts();
+    aco.setMaxIterations(iterations);
+    aco.setSeed(12345);
+    aco.setDeterministic(deterministic);
+    aco.setLocalSearch(localSearch);
+    aco.setNumaReplicas(replicas);
+    if (pinning != numa::PinningPolicy::None) {
+        aco.setThreadPinning(pinning);
+    }
+    aco.setExecutionBackend(backendKind);
+    if (pipelined && backendKind != BackendKind::OpenMP) {
+        std::cerr << "--pipelined schedules its own OpenMP teams, --backend is ignored\n";
+        aco.setExecutionBackend(BackendKind::OpenMP);
+    }
 
     using clock_type = std::chrono::steady_clock;
     auto t_start = clock_type::now();
 
-    for (int it = 0; it < iterations; ++it) {
-
-#if ENABLE_PARALLEL
-#pragma omp parallel
-        {
-            std::mt19937 threadGen(
-                12345 + omp_get_thread_num() + it * 9973
-            );
-            std::uniform_int_distribution<int> startDist(
-                0, numberOfCities - 1
-            );
-            std::uniform_real_distribution<float> uni01(0.0f, 1.0f);
-
-            // Thread-local probability row 
-            std::vector<float> localProb(numberOfCities);
-
-#pragma omp for schedule(static)
-            for (int antIndex = 0;
-                antIndex < static_cast<int>(ants.size());
-                ++antIndex) {
-                auto& ant = ants[antIndex];
-
-                int start = startDist(threadGen);
-                ant->visitCity(cities[start]);
-
-                while (static_cast<int>(ant->route.size()) < numberOfCities + 1) {
-                    float u = uni01(threadGen);
-                    int nextIdx = aco.selectNextCity(ant, &localProb, u);
-                    ant->currCity = cities[nextIdx];
-                    ant->visitCity();
-                }
-            }
-        } // end parallel region
+    // All iterations run on the execution backend: one persistent thread team for OpenMP
+    // (plus an update team when pipelined), phase by phase for the others
+    if (pipelined) {
+        aco.runPipelined();
+    }
+    else {
+        aco.run();
+    }
 
-#else
-        // Sequential path
-        for (auto& ant : ants) {
-            int start = std::uniform_int_distribution<int>(
-                0, numberOfCities - 1
-            )(gen);
+    auto t_end = clock_type::now();
+    std::chrono::duration<double> elapsed = t_end - t_start;
 
-            ant->visitCity(cities[start]);
+    const ExecutionBackend& backend = aco.getExecutionBackend();
+    std::cout << "Total execution time (headless, " << backendName(backend.kind()) << " backend, threads="
+        << backend.concurrency() << "): " << elapsed.count() << " s\n";
 
-            while (static_cast<int>(ant->route.size()) < numberOfCities + 1) {
-                int nextIdx = aco.selectNextCity(ant);
-                ant->currCity = cities[nextIdx];
-                ant->visitCity();
-            }
-        }
-#endif
+    std::cout << "Best tour length: " << aco.getBestLength() << "\n";
+    std::cout << "Best tour improvements: " << aco.getBestTours().publications() << "\n";
+    std::cout << "Startup time: " << aco.getStartupTimings().total << " s\n";
 
-        // Pheromone update once per iteration (sequential)
-        aco.updatePheromones();
+    if (numaReport) {
+        aco.printPlacementReport(std::cout);
+    }
 
-        // Reset ants for next iteration
-        for (auto& ant : ants) {
-            ant->reset();
+    // Load balance report of the ant scheduler (OpenMP run() and runPipelined() only)
+    if (aco.getScheduler()) {
+        const WorkStealingScheduler& scheduler = *aco.getScheduler();
+        const auto& stats = scheduler.stats();
+        std::cout << "Work stealing: " << scheduler.totalSteals() << " steals, "
+            << scheduler.totalIdleSeconds() << " s idle over " << stats.size() << " threads\n";
+        for (size_t w = 0; w < stats.size(); ++w) {
+            std::cout << "  thread " << w << ": " << stats[w].tasksRun << " tasks, "
+                << stats[w].steals << " steals, " << stats[w].idleSeconds << " s idle\n";
         }
     }
 
-    auto t_end = clock_type::now();
-    std::chrono::duration<double> elapsed = t_end - t_start;
-
-#if ENABLE_PARALLEL
-    int threads_used = omp_get_max_threads();
-#else
-    int threads_used = 1;
-#endif
-
-    std::cout << "Total execution time (headless, "
-#if ENABLE_PARALLEL
-        << "OpenMP, threads=" << threads_used
-#else
-        << "sequential"
-#endif
-        << "): " << elapsed.count() << " s\n";
-
     if (numberOfCities <= 10) {
-        compareACOBestRoute(cities, aco.getPheromones());
+        compareACOBestRoute(cities, aco.getPheromones(), aco.getBestRoute());
     }
     else {
         std::cout << "Skipping brute-force TSP check for n = "
             << numberOfCities << " (too large).\n";
     }
 
+    if (islands > 0) {
+        IslandConfig config;
+        config.islands = islands;
+        config.antsPerIsland = numAnts;
+        config.Q = Q;
+        config.evaporationRate = evaporationRate;
+        config.alpha = alpha;
+        config.beta = beta;
+
+        IslandModel model(cities, config);
+        auto island_start = clock_type::now();
+        model.run(iterations);
+        std::chrono::duration<double> island_elapsed = clock_type::now() - island_start;
+
+        std::cout << "Island model time: " << island_elapsed.count() << " s\n";
+        model.printReport(std::cout);
+    }
+
+    if (deterministic && !checkThreadCountInvariance(cities, numAnts, iterations, { 1, 2, 3, 4, 8 })) {
+        return 1;
+    }
+    if (deterministic && !checkStepTeamSelection(3000, 1024, 4)) {
+        return 1;
+    }
+
+    if (startupBench) {
+        benchmarkStartup({ 1000, 2000, 5000, 10000 }, numAnts);
+    }
+
+    if (backendBench) {
+        benchmarkBackends(cities, numAnts, iterations);
+    }
+
+    if (asyncBench) {
+        benchmarkUpdateModes(cities, numAnts, { iterations / 4, iterations / 2, iterations, iterations * 2 });
+    }
+
+    // Independent solvers with different parameters running side by side
+    if (stress) {
+        return stressConcurrentSolvers(cities, 8, iterations) ? 0 : 1;
+    }
+
     return 0;
 }
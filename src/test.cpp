@@ -1,7 +1,13 @@
 #include "test.h"
+#include "ACO.h"
+#include "Kernels.h"
 #include <iostream>
 #include <numeric>
 #include <cmath>
+#include <thread>
+#include <cstring>
+#include <chrono>
+#include <cstdio>
 
 // Function to calculate the distance of a given route
 float calculateRouteDistance(const vector<shared_ptr<city>>& cities,
@@ -52,7 +58,7 @@ vector<int> bruteForceTSP(const vector<shared_ptr<city>>& cities) {
 
 // Function to execute and compare the brute-force and ACO results
 void compareACOBestRoute(vector<shared_ptr<city>>& cities,
-    vector<vector<float>>& pheromones) {
+    const AlignedMatrix& pheromones, const vector<int>& bestRoute) {
     bool       haveExact = false;
     vector<int> shortestRoute;
     float       bruteForceDistance = 0.0f;
@@ -70,16 +76,17 @@ void compareACOBestRoute(vector<shared_ptr<city>>& cities,
             << cities.size() << " (too large)." << std::endl;
     }
 
-    // Greedy reconstruction from pheromone matrix (visit each city exactly once)
-    vector<int>  acoBestRoute;
+    // The solver's tracked best tour, or a greedy reconstruction from the pheromone
+    // matrix (visit each city exactly once) when none was recorded
+    vector<int>  acoBestRoute = bestRoute;
     vector<bool> visited(cities.size(), false);
     int current = 0;
-    if (!cities.empty()) {
+    if (acoBestRoute.empty() && !cities.empty()) {
         acoBestRoute.push_back(current);
         visited[current] = true;
     }
 
-    for (size_t step = 1; step < cities.size(); ++step) {
+    for (size_t step = 1; bestRoute.empty() && step < cities.size(); ++step) {
         int   next = -1;
         float best = -1.0f;
         for (size_t j = 0; j < cities.size(); ++j) {
@@ -95,7 +102,7 @@ void compareACOBestRoute(vector<shared_ptr<city>>& cities,
     }
 
     float acoDistance = calculateRouteDistance(cities, acoBestRoute);
-    std::cout << "ACO greedy reconstruction distance: "
+    std::cout << (bestRoute.empty() ? "ACO greedy reconstruction distance: " : "ACO best tour distance: ")
         << acoDistance << std::endl;
 
     if (haveExact) {
@@ -109,8 +116,219 @@ void compareACOBestRoute(vector<shared_ptr<city>>& cities,
         }
     }
     else {
-        std::cout << "Exact baseline not available; only ACO greedy distance "
+        std::cout << "Exact baseline not available; only the ACO distance "
             "is reported."
             << std::endl;
     }
 }
+
+// Outcome of one solver configuration, compared bit for bit between the solo and concurrent runs
+struct SolverResult {
+    float bestLength = 0.0f;
+    uint64_t pheromoneHash = 0;
+};
+
+// Hashes the raw bits of the pheromone matrix (FNV-1a)
+static uint64_t hashPheromones(const AlignedMatrix& pheromones) {
+    uint64_t hash = 1469598103934665603ull;
+    for (size_t i = 0; i < pheromones.rows(); ++i) {
+        for (float value : pheromones[i]) {
+            uint32_t bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+            hash = (hash ^ bits) * 1099511628211ull;
+        }
+    }
+    return hash;
+}
+
+// Builds and runs solver number index; each index gets its own alpha, beta, seed and evaporation rate
+// One thread per solver keeps the run reproducible for a given seed
+static SolverResult runStressSolver(vector<shared_ptr<city>>& cities, int index, int iterations) {
+    ACO aco(cities, 16, 100.0f, 0.3f + 0.1f * static_cast<float>(index % 5));
+    aco.setAlpha(1.0f + static_cast<float>(index % 3));
+    aco.setBeta(2.0f + static_cast<float>(index % 4) + 0.5f * static_cast<float>(index % 2));
+    aco.setSeed(1000u + 17u * static_cast<unsigned>(index));
+    aco.setThreadCount(1);
+    aco.setMaxIterations(iterations);
+    aco.run();
+
+    return { aco.getBestLength(), hashPheromones(aco.getPheromones()) };
+}
+
+bool stressConcurrentSolvers(vector<shared_ptr<city>>& cities, int numSolvers, int iterations) {
+    // Reference: every configuration on its own
+    vector<SolverResult> expected(numSolvers);
+    for (int s = 0; s < numSolvers; ++s) {
+        expected[s] = runStressSolver(cities, s, iterations);
+    }
+
+    // All configurations at once; only the city list is shared, and it is read-only
+    vector<SolverResult> concurrent(numSolvers);
+    vector<std::thread> workers;
+    for (int s = 0; s < numSolvers; ++s) {
+        workers.emplace_back([&, s]() {
+            concurrent[s] = runStressSolver(cities, s, iterations);
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    bool allMatch = true;
+    for (int s = 0; s < numSolvers; ++s) {
+        bool match = expected[s].bestLength == concurrent[s].bestLength &&
+            expected[s].pheromoneHash == concurrent[s].pheromoneHash;
+        allMatch = allMatch && match;
+        std::cout << "  solver " << s << ": best " << concurrent[s].bestLength
+            << (match ? " (matches solo run)" : " (differs from solo run)") << std::endl;
+    }
+    std::cout << "Concurrent solver stress test "
+        << (allMatch ? "passed" : "FAILED") << " with " << numSolvers << " solvers." << std::endl;
+    return allMatch;
+}
+
+void benchmarkUpdateModes(vector<shared_ptr<city>>& cities, int numAnts, const vector<int>& budgets) {
+    using clock_type = std::chrono::steady_clock;
+    std::cout << "Update mode benchmark, n = " << cities.size() << ", " << numAnts << " ants, "
+        << omp_get_max_threads() << " threads" << std::endl;
+    std::cout << "  iterations | mode  | seconds  | ants/s     | best" << std::endl;
+
+    for (int iterations : budgets) {
+        const char* modeNames[] = { "sync", "async", "pipe" };
+        for (int mode = 0; mode < 3; ++mode) {
+            ACO aco(cities, numAnts, 100.0f, 0.5f);
+            aco.setSeed(12345);
+            aco.setMaxIterations(iterations);
+
+            auto start = clock_type::now();
+            if (mode == 1) {
+                aco.runAsynchronous();
+            }
+            else if (mode == 2) {
+                aco.runPipelined();
+            }
+            else {
+                aco.run();
+            }
+            double seconds = std::chrono::duration<double>(clock_type::now() - start).count();
+            double antsPerSecond = static_cast<double>(iterations) * numAnts / seconds;
+
+            std::printf("  %10d | %-5s | %8.4f | %10.0f | %.2f\n", iterations, modeNames[mode],
+                seconds, antsPerSecond, aco.getBestLength());
+        }
+    }
+}
+
+void benchmarkBackends(vector<shared_ptr<city>>& cities, int numAnts, int iterations) {
+    using clock_type = std::chrono::steady_clock;
+    std::cout << "Backend benchmark, n = " << cities.size() << ", " << numAnts << " ants, "
+        << iterations << " iterations" << std::endl;
+    std::cout << "  backend     | threads | seconds  | ants/s     | best" << std::endl;
+
+    // Every backend through run(); the extra last row is OpenMP driven phase by phase like the
+    // other backends, which separates the cost of the schedule from that of the threading library
+    for (int b = 0; b < 5; ++b) {
+        const bool phased = b == 4;
+        ACO aco(cities, numAnts, 100.0f, 0.5f);
+        aco.setSeed(12345);
+        aco.setMaxIterations(iterations);
+        aco.setExecutionBackend(phased ? BackendKind::OpenMP : static_cast<BackendKind>(b));
+
+        auto start = clock_type::now();
+        if (phased) {
+            auto loops = makeExecutionBackend(BackendKind::OpenMP);
+            aco.runOnBackend(*loops);
+        }
+        else {
+            aco.run();
+        }
+        double seconds = std::chrono::duration<double>(clock_type::now() - start).count();
+        double antsPerSecond = static_cast<double>(iterations) * numAnts / seconds;
+
+        const ExecutionBackend& backend = aco.getExecutionBackend();
+        std::printf("  %-11s | %7d | %8.4f | %10.0f | %.2f\n", phased ? "openmp-loop" : backendName(backend.kind()),
+            backend.concurrency(), seconds, antsPerSecond, aco.getBestLength());
+    }
+}
+
+void benchmarkStartup(const vector<int>& sizes, int numAnts) {
+    std::cout << "Startup benchmark, " << omp_get_max_threads() << " threads, "
+        << kernels::simdLevelName(kernels::active().level) << " kernels" << std::endl;
+    std::cout << "       n | distances | heuristics | candidates | pheromones | choice   | total" << std::endl;
+
+    for (int n : sizes) {
+        vector<shared_ptr<city>> cities;
+        std::mt19937 gen(12345);
+        std::uniform_real_distribution<float> dist(0.0f, 1000.0f);
+        for (int i = 0; i < n; ++i) {
+            cities.push_back(std::make_shared<city>(i, false, Vector2{ dist(gen), dist(gen) }));
+        }
+
+        ACO aco(cities, numAnts, 100.0f, 0.5f);
+        const StartupTimings& t = aco.getStartupTimings();
+        std::printf("  %6d | %9.4f | %10.4f | %10.4f | %10.4f | %8.4f | %.4f s\n", n, t.distances, t.heuristics,
+            t.candidateLists, t.pheromones, t.choiceInfo, t.total);
+    }
+}
+
+bool checkThreadCountInvariance(vector<shared_ptr<city>>& cities, int numAnts, int iterations,
+    const vector<int>& threadCounts) {
+    bool allMatch = true;
+    SolverResult reference;
+    vector<int> referenceRoute;
+
+    for (size_t k = 0; k < threadCounts.size(); ++k) {
+        ACO aco(cities, numAnts, 100.0f, 0.5f);
+        aco.setSeed(12345);
+        aco.setThreadCount(threadCounts[k]);
+        aco.setMaxIterations(iterations);
+        aco.run();
+
+        SolverResult result{ aco.getBestLength(), hashPheromones(aco.getPheromones()) };
+        if (k == 0) {
+            reference = result;
+            referenceRoute = aco.getBestRoute();
+        }
+        bool match = result.bestLength == reference.bestLength && result.pheromoneHash == reference.pheromoneHash
+            && aco.getBestRoute() == referenceRoute;
+        allMatch = allMatch && match;
+        std::cout << "  " << threadCounts[k] << " threads: best " << result.bestLength
+            << (match ? " (identical)" : " (differs)") << std::endl;
+    }
+    std::cout << "Thread-count invariance " << (allMatch ? "passed" : "FAILED") << "." << std::endl;
+    return allMatch;
+}
+
+bool checkStepTeamSelection(int cities, int threshold, int threads) {
+    vector<shared_ptr<city>> instance;
+    std::mt19937 gen(4242);
+    std::uniform_real_distribution<float> dist(0.0f, 1000.0f);
+    for (int i = 0; i < cities; ++i) {
+        instance.push_back(std::make_shared<city>(i, false, Vector2{ dist(gen), dist(gen) }));
+    }
+
+    // Two ants and every city as a candidate, so each step's weight scan is a long row
+    SolverResult results[2];
+    vector<int> routes[2];
+    uint64_t weightScans = 0;
+    for (int k = 0; k < 2; ++k) {
+        ACO aco(instance, 2, 100.0f, 0.5f, 0);
+        aco.setSeed(12345);
+        aco.setParallelSelectionThreshold(threshold);
+        aco.setThreadCount(k == 0 ? 1 : threads);
+        aco.setMaxIterations(2);
+        aco.run();
+        results[k] = { aco.getBestLength(), hashPheromones(aco.getPheromones()) };
+        routes[k] = aco.getBestRoute();
+        weightScans = aco.getTeamScans(StepScan::Weights);
+    }
+
+    const bool identical = results[0].bestLength == results[1].bestLength
+        && results[0].pheromoneHash == results[1].pheromoneHash && routes[0] == routes[1];
+    const bool passed = weightScans > 0 && identical;
+    std::cout << "Step-team selection, " << cities << " cities, 2 ants, " << threads << " threads: "
+        << weightScans << " team weight scans, best " << results[1].bestLength
+        << (identical ? " (identical to 1 thread)" : " (differs from 1 thread)") << std::endl;
+    std::cout << "Step-team selection " << (passed ? "passed" : "FAILED") << "." << std::endl;
+    return passed;
+}
@@ -2,6 +2,7 @@
 #define TEST_H
 
 #include "Ant.h"
+#include "AlignedMatrix.h"
 
 using namespace std;
 
@@ -14,6 +15,35 @@ float calculateRouteDistance(const vector<shared_ptr<city>> &cities, const vecto
 vector<int> bruteForceTSP(const vector<shared_ptr<city>>& cities);
 
 // Function to execute and compare the brute-force and ACO results
-void compareACOBestRoute(vector<shared_ptr<city>> &cities, vector<vector<float>> &pheromones);
+// bestRoute is the solver's best tour; when empty a route is rebuilt greedily from the pheromones
+void compareACOBestRoute(vector<shared_ptr<city>> &cities, const AlignedMatrix &pheromones,
+    const vector<int> &bestRoute = {});
+
+// Runs numSolvers ACO instances with different alpha, beta, seed and evaporation rate at the
+// same time, one std::thread each, over a shared city list
+// Returns true when every solver matches the same configuration run on its own
+bool stressConcurrentSolvers(vector<shared_ptr<city>> &cities, int numSolvers, int iterations);
+
+// Runs the synchronous, asynchronous (Hogwild) and pipelined modes on the same instance for
+// every iteration budget and prints wall clock, ants per second and best tour of each
+void benchmarkUpdateModes(vector<shared_ptr<city>> &cities, int numAnts, const vector<int> &budgets);
+
+// Runs the same instance with run() on every execution backend (and OpenMP once more as
+// phased loops) and prints wall clock, ants per second and best tour of each
+void benchmarkBackends(vector<shared_ptr<city>> &cities, int numAnts, int iterations);
+
+// Builds an ACO instance on random cities for every size and prints how long each
+// constructor phase took
+void benchmarkStartup(const vector<int> &sizes, int numAnts);
+
+// Runs the same solve, default settings, with every thread count and checks that the best
+// tour and the final pheromones are bit-identical
+bool checkThreadCountInvariance(vector<shared_ptr<city>> &cities, int numAnts, int iterations,
+    const vector<int> &threadCounts);
+
+// Solves a random instance of the given size with two ants, every city as a candidate and
+// the given parallel-selection threshold, once on one thread and once on threads threads
+// Passes when the second run shared weight scans in StepTeams and both runs are bit-identical
+bool checkStepTeamSelection(int cities, int threshold, int threads);
 
 #endif